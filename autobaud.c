@@ -0,0 +1,132 @@
+/******************************************************************************/
+/* File    : autobaud.c                                                       */
+/* Function: Bit rate detection of the NMEA source                            */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+/*
+ * The EUSART's auto-baud detection needs a 0x55 to measure, which NMEA
+ * doesn't guarantee, so the candidate rates are swept instead. A rate is
+ * locked as soon as a sentence with a good checksum is received, and the
+ * sweep resumes when characters or errors keep coming in without one.
+ * Detection is driven by received traffic only: a silent source keeps the
+ * current rate.
+ */
+#include "uart1.h"
+#include "nmea.h"
+
+#include "autobaud.h"
+
+#if defined(NMEA_AUTOBAUD) && !defined(NMEA_OUT_UART2)
+#error UART1 tx shares the bit rate generator with rx, autobaud would change the output rate too
+#endif
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define ARRAY_SIZE(x)           (sizeof(x) / sizeof((x)[0]))
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static const unsigned long  rates[] = {
+	4800, 9600, 19200, 38400, 57600, 115200
+};
+static unsigned char        rate_ndx;
+static unsigned char        locked;
+static unsigned int         last_count;    /* uart1_rx_count() at the last call */
+static unsigned int         last_errors;   /* uart1_rx_errors() at the last call */
+static unsigned char        last_valid;    /* nmea_valid() at the last call */
+static unsigned int         events;        /* Characters and errors since the last valid sentence or rate change */
+static unsigned char        errors;        /* Errors since the last valid sentence or rate change */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void restart(void)
+{
+	events = 0;
+	errors = 0;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void autobaud_init(unsigned long bitrate)
+{
+	for (rate_ndx = 0; rate_ndx < ARRAY_SIZE(rates) - 1; rate_ndx++)
+		if (rates[rate_ndx] == bitrate)
+			break;
+	locked      = 0;
+	last_count  = uart1_rx_count();
+	last_errors = uart1_rx_errors();
+	last_valid  = nmea_valid();
+	restart();
+}
+
+
+unsigned char autobaud_work(void)
+{
+	unsigned int   count  = uart1_rx_count();
+	unsigned int   errs   = uart1_rx_errors();
+	unsigned char  valid  = nmea_valid();
+	unsigned int   new_errors;
+	unsigned long  new_events;
+
+	/* A good checksum proves the rate */
+	if (valid != last_valid) {
+		last_valid  = valid;
+		last_count  = count;
+		last_errors = errs;
+		locked = 1;
+		restart();
+		return 0;
+	}
+
+	/* Account what came in since the last call (the counters wrap after 65536 characters, over 5 s even at 115200 bit/s) */
+	new_errors  = errs - last_errors;
+	new_events  = (unsigned long)(count - last_count) + new_errors;
+	if (events + new_events > 0xffff)
+		events = 0xffff;
+	else
+		events += (unsigned int)new_events;
+	if ((unsigned long)errors + new_errors > 0xff)
+		errors = 0xff;
+	else
+		errors += (unsigned char)new_errors;
+	last_count  = count;
+	last_errors = errs;
+
+	if (locked) {
+		if (events < AUTOBAUD_LOSS_EVENTS && errors < AUTOBAUD_LOSS_ERRORS)
+			return 0;
+	} else {
+		if (events < AUTOBAUD_SEARCH_EVENTS && errors < AUTOBAUD_SEARCH_ERRORS)
+			return 0;
+	}
+
+	/* Nothing sensible at this rate, try the next one */
+	locked = 0;
+	if (++rate_ndx >= ARRAY_SIZE(rates))
+		rate_ndx = 0;
+	uart1_set_bitrate(rates[rate_ndx]);
+	restart();
+
+	return 0;
+}
+
+
+unsigned long autobaud_bitrate(void)
+{
+	return rates[rate_ndx];
+}
+
+
+unsigned char autobaud_locked(void)
+{
+	return locked;
+}
@@ -0,0 +1,29 @@
+/******************************************************************************/
+/* File    : autobaud.h                                                       */
+/* Function: Header file of 'autobaud.c'                                      */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef AUTOBAUD_H
+#define AUTOBAUD_H
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define AUTOBAUD_SEARCH_EVENTS  192     /* Characters and errors received without a valid sentence before trying the next rate */
+#define AUTOBAUD_SEARCH_ERRORS  8       /* Errors received without a valid sentence before trying the next rate */
+#define AUTOBAUD_LOSS_EVENTS    512     /* As AUTOBAUD_SEARCH_EVENTS, but when locked */
+#define AUTOBAUD_LOSS_ERRORS    32      /* As AUTOBAUD_SEARCH_ERRORS, but when locked */
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void          autobaud_init   (unsigned long  bitrate);
+unsigned char autobaud_work   (void);
+unsigned long autobaud_bitrate(void);
+unsigned char autobaud_locked (void);
+
+
+#endif /* AUTOBAUD_H */
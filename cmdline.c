@@ -10,13 +10,19 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "uart2.h"
 #include "cmdline.h"
 
+#if CMDLINE_REPLY_LEN > UART2_TX_LEN
+#error A pass of a command must fit in the console queue
+#endif
+
 
 /******************************************************************************/
 /*** Macros                                                                 ***/
 /******************************************************************************/
 #define PROMPT                 "# "
+#define CMDLINE_BURST_LEN      8     /* Number of bytes processed from the console at once */
 
 
 /******************************************************************************/
@@ -24,7 +30,13 @@
 /******************************************************************************/
 extern const struct command_t  commands[];
 static char                    linebuffer[CMDLINE_LENGTH_MAX];
+static unsigned char           curcolumn;           /* Number of characters in linebuffer */
 static unsigned char           localecho = 1;
+static int                     (*pending)(int argc, char *argv[]);  /* Command being run, NULL if none */
+static int                     (*posted)(int argc, char *argv[]);   /* Output to run like a command once the command line is idle, NULL if none */
+static unsigned char           pass;                /* Number of times it was called before */
+static int                     pending_argc;
+static char                    *pending_argv[ARGS_MAX];  /* Pointing into linebuffer, so no input is taken until the command completes */
 
 
 /******************************************************************************/
@@ -44,11 +56,54 @@ static int cmd2index(char *cmd)
 }
 
 
+static int unknown_command(int argc, char *argv[])
+{
+	printf("Unknown command '%s'\n", argv[0]);
+
+	return ERR_OK;
+}
+
+
+/* Run the next pass of the pending command */
+static void run_command(void)
+{
+	int  result;
+
+	/* Replies are asked for, so they wait for room in the console queue rather than being cut short */
+	uart2_tx_wait(1);
+	result = pending(pending_argc, pending_argv);
+	switch (result) {
+	case ERR_OK:
+		break;
+	case ERR_MORE:
+		pass++;
+		break;
+	case ERR_SYNTAX:
+		printf("Syntax error\n");
+		break;
+	case ERR_IO:
+		printf("I/O error\n");
+		break;
+	case ERR_PARAM:
+		printf("Parameter error\n");
+		break;
+	default:
+		printf("Unknown error\n");
+	}
+	if (result != ERR_MORE) {
+		pending = NULL;
+		if (localecho)
+			printf(PROMPT);
+	}
+	uart2_tx_wait(0);
+}
+
+
 static void proc_line(char *line)
 {
 	unsigned int  len = strlen(line);
 	int           argc = 0;
-	char          *argv[ARGS_MAX];
+	char          **argv = pending_argv;
 	int           index;
 
 	/* Trim trailing white spaces */
@@ -76,32 +131,16 @@ static void proc_line(char *line)
 			line++;
 	}
 
+	/* The command runs from cmdline_work(), once there's room for its reply, and so does the error for an unknown one */
 	index = cmd2index(argv[0]);
-	if (index >= 0) {
-		switch (commands[index].function(argc, argv)) {
-		case ERR_OK:
-			break;
-		case ERR_SYNTAX:
-			printf("Syntax error\n");
-			break;
-		case ERR_IO:
-			printf("I/O error\n");
-			break;
-		case ERR_PARAM:
-			printf("Parameter error\n");
-			break;
-		default:
-			printf("Unknown error\n");
-		}
-	} else
-		printf("Unknown command '%s'\n", argv[0]);
+	pending      = (index >= 0) ? commands[index].function : unknown_command;
+	pass         = 0;
+	pending_argc = argc;
 }
 
 
 static void proc_char(char rxd)
 {
-	static unsigned char  curcolumn = 0;
-
 	if ((rxd >= ' ') && (rxd <= '~')) {
 		if (curcolumn < (CMDLINE_LENGTH_MAX-1)) {
 			/* Add readable characters to the line as long as the buffer permits */
@@ -126,7 +165,8 @@ static void proc_char(char rxd)
 		}
 		curcolumn = 0;
 
-		if (localecho)
+		/* A command prints the prompt when it completes */
+		if (localecho && !pending)
 			printf(PROMPT);
 	} else if (rxd == 0x7f) {
 		/* Delete last character from the line */
@@ -151,14 +191,53 @@ void cmdline_init(void)
 }
 
 
-void cmdline_work(void)
+unsigned char cmdline_work(void)
 {
-	char  byte;
+	char           rxd;
+	unsigned char  count;
+
+	/* Start posted output once no command runs and no line is being typed, so it doesn't mix with either */
+	if (!pending && posted && !curcolumn) {
+		pending      = posted;
+		posted       = NULL;
+		pass         = 0;
+		pending_argc = 0;
+	}
 
-	/* Read input data from stdin */
-	while ((byte = getchar()) != (char)EOF)
-		/* Process the byte */
-		proc_char((char)byte);
+	/* Run a command a pass at a time, and only once its next line fits in the console queue, so it doesn't stall the main loop */
+	if (pending) {
+		if (uart2_tx_room(CMDLINE_REPLY_LEN))
+			run_command();
+		return 1;
+	}
+
+	/* Process one burst of input data from the console, up to a line that starts a command */
+	for (count = 0; count < CMDLINE_BURST_LEN && !pending; count++) {
+		if (!uart2_read(&rxd, 1))
+			return pending != NULL;
+		proc_char(rxd);
+	}
+
+	/* There may be more */
+	return 1;
+}
+
+
+/* Number of times the running command was called before, for commands that print their reply a line per pass */
+unsigned char cmdline_pass(void)
+{
+	return pass;
+}
+
+
+/*
+ * Have a function called like a command without arguments, once the command
+ * line is idle, for output that must not mix with command replies. Takes one
+ * function at a time: the caller keeps track of whether it completed.
+ */
+void cmdline_post(int (*function)(int argc, char *argv[]))
+{
+	posted = function;
 }
 
 
@@ -187,17 +266,18 @@ int cmdline_echo(int argc, char *argv[])
 #ifdef CMDLINE_HELP
 int cmdline_help(int argc, char *argv[])
 {
-	int  index = 0;
+	unsigned char  index = cmdline_pass();
 
 	if (argc > 1)
 		return ERR_SYNTAX;
 
-	printf("Known commands:\n");
-	while (commands[index].function) {
-		printf("%s\n", commands[index].cmd);
-		index++;
+	/* A line per pass */
+	if (!index) {
+		printf("Known commands:\n");
+		return ERR_MORE;
 	}
+	printf("%s\n", commands[index - 1].cmd);
 
-	return ERR_OK;
+	return commands[index].function ? ERR_MORE : ERR_OK;
 }
 #endif /* CMDLINE_HELP */
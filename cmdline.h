@@ -14,6 +14,7 @@
 #define CMDLINE_HELP                    /* Enable help command */
 #define CMDLINE_LENGTH_MAX      ( 20)   /* Maximum length of a complete command line */
 #define ARGS_MAX                (  4)   /* Maximum number of arguments, including command */
+#define CMDLINE_REPLY_LEN       ( 48)   /* Room in the console queue a command waits for before each pass: the longest line printed per pass ('filter' types), and the prompt */
 
 
 /* Errors reported by command implementations, triggering standard error messages */
@@ -21,6 +22,7 @@
 #define ERR_SYNTAX              (-1)    /* Return this if the command contained a syntax error, such as too few or too many parameters */
 #define ERR_IO                  (-2)    /* Return this if the command could not be executed due to external factors */
 #define ERR_PARAM               (-3)    /* Return this if the command had erroneous parameters, such as erroneous values or types */
+#define ERR_MORE                (  1)   /* Return this to be called again with the same arguments on a later pass, to print a long reply a line at a time */
 
 
 /******************************************************************************/
@@ -36,7 +38,9 @@ struct command_t {
 /*** Functions                                                              ***/
 /******************************************************************************/
 void            cmdline_init            (void);
-void            cmdline_work            (void);
+unsigned char   cmdline_work            (void);
+unsigned char   cmdline_pass            (void);
+void            cmdline_post            (int                    (*function)(int argc, char *argv[]));
 
 /* Built-in command-line commands */
 int             cmdline_echo            (int                    argc,
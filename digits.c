@@ -0,0 +1,121 @@
+/******************************************************************************/
+/* File    : digits.c                                                         */
+/* Function: Fixed-width decimal and hexadecimal digit conversion             */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* These replace strtoul() and sprintf() in the NMEA path, which pull in      */
+/* large and slow stdio/stdlib code on XC8. The get functions read two        */
+/* characters, stopping at the first that isn't a digit, so they never read   */
+/* past a 0-terminator. The put functions write exactly two characters, or    */
+/* for digits_put_dec() as many as the value takes, and leave terminating     */
+/* the string to the caller.                                                  */
+/******************************************************************************/
+#include "digits.h"
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static int hexval(char ch)
+{
+	if (ch >= '0' && ch <= '9')
+		return ch - '0';
+	if (ch >= 'A' && ch <= 'F')
+		return ch - 'A' + 10;
+	if (ch >= 'a' && ch <= 'f')
+		return ch - 'a' + 10;
+
+	return -1;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/* Convert two decimal digits into a value [0, 99], returns -1 on any non-digit */
+int digits_get_dec2(const char *str, unsigned char *value)
+{
+	unsigned char  hi = (unsigned char)(str[0] - '0');
+	unsigned char  lo;
+
+	/* Characters below '0' wrap around to large values, so one test per digit suffices. Don't look past a 0-terminator */
+	if (hi > 9)
+		return -1;
+	if ((lo = (unsigned char)(str[1] - '0')) > 9)
+		return -1;
+
+	/* hi * 10 as (hi << 3) + (hi << 1), as the PIC has no multiplier */
+	*value = (unsigned char)((hi << 3) + (hi << 1) + lo);
+
+	return 0;
+}
+
+
+/* Convert two hexadecimal digits (either case) into a value [0x00, 0xff], returns -1 on any non-digit */
+int digits_get_hex2(const char *str, unsigned char *value)
+{
+	int  hi = hexval(str[0]);
+	int  lo;
+
+	if (hi < 0)
+		return -1;
+	if ((lo = hexval(str[1])) < 0)
+		return -1;
+
+	*value = (unsigned char)((hi << 4) | lo);
+
+	return 0;
+}
+
+
+/* Write a value as two decimal digits, modulo 100 */
+void digits_put_dec2(char *str, unsigned char value)
+{
+	unsigned char  tens = 0;
+
+	/* Division by repeated subtraction is cheaper than a library division here */
+	while (value >= 100)
+		value -= 100;
+	while (value >= 10) {
+		value -= 10;
+		tens++;
+	}
+
+	str[0] = (char)('0' + tens);
+	str[1] = (char)('0' + value);
+}
+
+
+/* Write a value as two upper-case hexadecimal digits */
+void digits_put_hex2(char *str, unsigned char value)
+{
+	static const char  hex[] = "0123456789ABCDEF";
+
+	str[0] = hex[value >> 4];
+	str[1] = hex[value & 0x0f];
+}
+
+
+/* Write a value in decimal without leading zeros, returns the number of digits written [1, 5] */
+unsigned char digits_put_dec(char *str, unsigned int value)
+{
+	static const unsigned int  powers[] = { 10000, 1000, 100, 10 };
+	unsigned char              len = 0;
+	unsigned char              ndx;
+
+	/* Division by repeated subtraction, at most nine per digit */
+	for (ndx = 0; ndx < sizeof(powers) / sizeof(powers[0]); ndx++) {
+		char  digit = '0';
+
+		while (value >= powers[ndx]) {
+			value -= powers[ndx];
+			digit++;
+		}
+		if (len || digit != '0')
+			str[len++] = digit;
+	}
+	str[len++] = (char)('0' + value);
+
+	return len;
+}
@@ -0,0 +1,26 @@
+/******************************************************************************/
+/* File    : digits.h                                                         */
+/* Function: Header file of 'digits.c'                                        */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef DIGITS_H
+#define DIGITS_H
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+int           digits_get_dec2(const char     *str,
+                              unsigned char  *value);
+int           digits_get_hex2(const char     *str,
+                              unsigned char  *value);
+void          digits_put_dec2(char           *str,
+                              unsigned char  value);
+void          digits_put_hex2(char           *str,
+                              unsigned char  value);
+unsigned char digits_put_dec(char            *str,
+                              unsigned int   value);
+
+
+#endif /* DIGITS_H */
@@ -0,0 +1,97 @@
+/******************************************************************************/
+/* File    : event.c                                                          */
+/* Function: Events posted by interrupts, to wake up the run loop             */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef __x86_64__
+#include <xc.h>
+#endif /* __x86_64__ */
+
+#include "event.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#ifdef __x86_64__
+/* On the host, the model's idle hook plays the role of the interrupts */
+#define EVENT_LOCK()
+#define EVENT_UNLOCK()
+#define EVENT_IDLE()            event_idle_hook()
+#else
+#define EVENT_LOCK()            (GIE = 0)
+#define EVENT_UNLOCK()          (GIE = 1)
+/* Enter Idle with interrupts disabled: an enabled peripheral interrupt wakes the CPU up without vectoring, so no event can slip in between test and sleep */
+#define EVENT_IDLE()            do { CLRWDT(); SLEEP(); NOP(); } while (0)
+#endif /* __x86_64__ */
+
+#define WDT_PERIOD_2S           0x0b    /* WDTCON0.PS setting for a 1:65536 (2s) watchdog period */
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+#ifdef __x86_64__
+extern void                    event_idle_hook(void);
+#endif /* __x86_64__ */
+static volatile unsigned char  pending;
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void event_init(void)
+{
+	pending = 0;
+
+#ifndef __x86_64__
+	/* Select Idle rather than Sleep, so the peripherals and their clocks keep running */
+	CPUDOZEbits.IDLEN = 1;
+
+	/* A watchdog time-out wakes up from Idle instead of resetting, so it merely limits the idle time (requires WDTCPS to allow software control) */
+	WDTCON0bits.PS = WDT_PERIOD_2S;
+#endif /* __x86_64__ */
+}
+
+
+/* Post events, to be called from interrupt context (setting bits is atomic on the PIC) */
+void event_post(unsigned char events)
+{
+	pending |= events;
+}
+
+
+/* Fetch and clear the pending events, without waiting */
+unsigned char event_get(void)
+{
+	unsigned char  events;
+
+	EVENT_LOCK();
+	events  = pending;
+	pending = 0;
+	EVENT_UNLOCK();
+
+	return events;
+}
+
+
+/* Idle until at least one event is pending, then fetch and clear the pending events */
+unsigned char event_wait(void)
+{
+	unsigned char  events;
+
+	for (;;) {
+		EVENT_LOCK();
+		if (pending)
+			break;
+		EVENT_IDLE();
+		/* Re-enable interrupts to have the ones that woke us up serviced */
+		EVENT_UNLOCK();
+	}
+	events  = pending;
+	pending = 0;
+	EVENT_UNLOCK();
+
+	return events;
+}
@@ -0,0 +1,34 @@
+/******************************************************************************/
+/* File    : event.h                                                          */
+/* Function: Header file of 'event.c'                                         */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef EVENT_H
+#define EVENT_H
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+/* Events, posted from interrupt context */
+#define EVENT_UART1_RX          0x01    /* Character received on UART1 */
+#define EVENT_UART1_EOL         0x02    /* Line terminator received on UART1 */
+#define EVENT_UART2_RX          0x04    /* Character received on UART2 */
+#define EVENT_UART2_EOL         0x08    /* Line terminator received on UART2 */
+#define EVENT_RTC_SECOND        0x10    /* The real time clock completed a second */
+#define EVENT_UART1_ERR         0x20    /* Overrun or framing error on UART1 */
+#define EVENT_UART1_TX          0x40    /* Data handed to uart1_send() was sent */
+#define EVENT_UART2_TX          0x80    /* Data handed to uart2_send() was sent */
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void          event_init    (void);
+void          event_post    (unsigned char  events);
+unsigned char event_get     (void);
+unsigned char event_wait    (void);
+
+
+#endif /* EVENT_H */
@@ -0,0 +1,122 @@
+/******************************************************************************/
+/* File    : filter.c                                                         */
+/* Function: Selection of NMEA sentences by talker and type                   */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Decides on a sentence as soon as its address field is in, so an unwanted   */
+/* one costs no more than skipping its remaining characters. It's called from */
+/* the UART1 rx interrupt when framing sentences there, so the settings are   */
+/* single bytes, written at once from the main loop.                          */
+/******************************************************************************/
+#include <stddef.h>
+
+#include "filter.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define TYPE_LEN                (NMEA_ADDRESS_LEN - NMEA_TALKER_LEN)
+#define ARRAY_SIZE(x)           (sizeof(x) / sizeof((x)[0]))
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static const char                   talker_names[][NMEA_TALKER_LEN + 1] = { FILTER_TALKER_NAMES };
+static const char                   type_names[][TYPE_LEN + 1] = { FILTER_TYPE_NAMES };
+static volatile enum filter_mode_t  mode = FILTER_OFF;
+static volatile unsigned char       talkers = FILTER_TALKERS_DEFAULT;
+static volatile unsigned char       types = FILTER_TYPES_DEFAULT;
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+/* Mask bit of the name at str in a table of count names of size bytes each, the one after them if it's not in there */
+static unsigned char lookup(const char *str, const char *names, unsigned char size, unsigned char count)
+{
+	unsigned char  ndx;
+	unsigned char  ch;
+
+	for (ndx = 0; ndx < count; ndx++, names += size) {
+		for (ch = 0; ch < size - 1 && str[ch] == names[ch]; ch++)
+			;
+		if (ch == size - 1)
+			break;
+	}
+
+	return (unsigned char)(1 << ndx);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/*
+ * Decides on a sentence by its address field, of which only the first
+ * NMEA_ADDRESS_LEN characters are looked at. Returns NMEA_FILTER_PARSE,
+ * NMEA_FILTER_DROP or NMEA_FILTER_PASS.
+ */
+unsigned char filter_address(const char *address)
+{
+	enum filter_mode_t  current = mode;
+
+	if (current == FILTER_OFF)
+		return NMEA_FILTER_PARSE;
+
+	if ((talkers & lookup(address, talker_names[0], sizeof(talker_names[0]), ARRAY_SIZE(talker_names))) &&
+	    (types & lookup(&address[NMEA_TALKER_LEN], type_names[0], sizeof(type_names[0]), ARRAY_SIZE(type_names))))
+		return NMEA_FILTER_PARSE;
+
+	return (current == FILTER_PASS) ? NMEA_FILTER_PASS : NMEA_FILTER_DROP;
+}
+
+
+void filter_set(enum filter_mode_t new_mode, unsigned char new_talkers, unsigned char new_types)
+{
+	/* Turn it off while changing the masks, so no sentence sees half of the change */
+	mode    = FILTER_OFF;
+	talkers = new_talkers;
+	types   = new_types;
+	mode    = new_mode;
+}
+
+
+enum filter_mode_t filter_mode(void)
+{
+	return mode;
+}
+
+
+unsigned char filter_talkers(void)
+{
+	return talkers;
+}
+
+
+unsigned char filter_types(void)
+{
+	return types;
+}
+
+
+/* Name of a bit of the talker mask */
+const char *filter_talker_name(unsigned char bit)
+{
+	if (bit < ARRAY_SIZE(talker_names))
+		return talker_names[bit];
+
+	return (bit == ARRAY_SIZE(talker_names)) ? FILTER_OTHER_NAME : NULL;
+}
+
+
+/* Name of a bit of the type mask */
+const char *filter_type_name(unsigned char bit)
+{
+	if (bit < ARRAY_SIZE(type_names))
+		return type_names[bit];
+
+	return (bit == ARRAY_SIZE(type_names)) ? FILTER_OTHER_NAME : NULL;
+}
@@ -0,0 +1,50 @@
+/******************************************************************************/
+/* File    : filter.h                                                         */
+/* Function: Header file of 'filter.c'                                        */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "nmeactx.h"
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+/* Talkers and sentence types told apart, one mask bit each, in this order. Anything else takes the last bit */
+#define FILTER_TALKER_NAMES     "GP", "GL", "GA", "GB", "GN"
+#define FILTER_TYPE_NAMES       "RMC", "GGA", "ZDA", "GSA", "GSV", "VTG", "GLL"
+#define FILTER_OTHER_NAME       "*"
+
+#define FILTER_TALKERS_DEFAULT  0xff    /* All talkers */
+#define FILTER_TYPES_DEFAULT    0x07    /* RMC, GGA and ZDA, the ones converted */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+enum filter_mode_t {
+	FILTER_OFF = 0,                     /* Parse every sentence */
+	FILTER_DROP,                        /* Drop unwanted sentences after their address field */
+	FILTER_PASS,                        /* Send unwanted sentences on as received, without parsing them */
+	FILTER_MODES
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+unsigned char      filter_address (const char          *address);
+void               filter_set     (enum filter_mode_t  mode,
+                                   unsigned char       talkers,
+                                   unsigned char       types);
+enum filter_mode_t filter_mode    (void);
+unsigned char      filter_talkers (void);
+unsigned char      filter_types   (void);
+const char         *filter_talker_name(unsigned char   bit);
+const char         *filter_type_name(unsigned char     bit);
+
+
+#endif /* FILTER_H */
@@ -0,0 +1,215 @@
+/******************************************************************************/
+/* File    : benchscan.c                                                      */
+/* Function: Benchmark and cross-check of the bulk scanner kernels            */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Converts a synthetic log, with some damaged sentences and noise mixed in,  */
+/* byte by byte through nmea_ctx_char() and with each scanner kernel. All of  */
+/* them have to produce the same output and statistics. Reports MB/s for     */
+/* scanning alone (no handlers) and for the complete GPRMC conversion.        */
+/******************************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "nmeactx.h"
+#include "lt.h"
+#include "gen.h"
+#include "scan.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define LOG_LEN                 (64UL << 20)
+#define DAMAGE_EVERY            97      /* Corrupt one in this many sentences */
+#define NOISE_EVERY             89      /* Insert noise before one in this many sentences */
+#define FNV_OFFSET              0xcbf29ce484222325ULL
+#define FNV_PRIME               0x100000001b3ULL
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct result_t {
+	uint64_t            hash;           /* Of all converted output */
+	unsigned long       converted;
+	struct nmea_stat_t  stat;
+	double              seconds;
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static const struct nmea_t  convert[] = {
+	{"GPRMC", handle_gprmc},
+	{NULL,    NULL}
+};
+static const struct nmea_t  none[] = {
+	{NULL,    NULL}
+};
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct result_t  *result = ctx->user;
+	rtcsecs_t        utc_secs;
+	unsigned char    dst;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+	unsigned char    ndx;
+
+	if (lt_gprmc(NULL, argc, argv, &utc_secs, &dst))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+
+	for (ndx = 0; ndx < len; ndx++)
+		result->hash = (result->hash ^ (unsigned char)sentence[ndx]) * FNV_PRIME;
+	result->converted++;
+}
+
+
+static double now_s(void)
+{
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* A synthetic log, with damaged sentences and noise mixed in */
+static size_t make_log(char *buf, size_t size)
+{
+	char           sentence[2 * GEN_LEN_MAX];
+	unsigned long  n = 0;
+	size_t         len = 0;
+
+	while (len + sizeof(sentence) + 8 < size) {
+		unsigned long  epoch = n;
+		size_t         sentence_len = gen_stream(sentence, sizeof(sentence), &n, n + 1);
+
+		if (epoch % NOISE_EVERY == 0) {
+			memcpy(&buf[len], "\r\n*$$\x7f\n", 7);
+			len += 7;
+		}
+		if (epoch % DAMAGE_EVERY == 0)
+			sentence[sentence_len / 2] ^= 0x01;
+		memcpy(&buf[len], sentence, sentence_len);
+		len += sentence_len;
+	}
+
+	return len;
+}
+
+
+static void run_bytes(const struct nmea_t *nmea, const char *log, size_t len, struct result_t *result)
+{
+	struct nmea_ctx_t  ctx;
+	size_t             ndx;
+	double             start;
+
+	memset(result, 0, sizeof(*result));
+	result->hash = FNV_OFFSET;
+	nmea_ctx_init(&ctx, nmea, result);
+
+	start = now_s();
+	for (ndx = 0; ndx < len; ndx++)
+		nmea_ctx_char(&ctx, log[ndx]);
+	result->seconds = now_s() - start;
+	result->stat    = ctx.stat;
+}
+
+
+static void run_scan(enum scan_impl_t impl, const struct nmea_t *nmea, const char *log, char *work, size_t len, struct result_t *result)
+{
+	struct nmea_ctx_t  ctx;
+	double             start;
+
+	memset(result, 0, sizeof(*result));
+	result->hash = FNV_OFFSET;
+	nmea_ctx_init(&ctx, nmea, result);
+	memcpy(work, log, len);             /* The scanner works in place */
+
+	start = now_s();
+	scan(impl, &ctx, work, len);
+	result->seconds = now_s() - start;
+	result->stat    = ctx.stat;
+}
+
+
+static int same(const struct result_t *a, const struct result_t *b)
+{
+	/* The scanners hunt for headers, rather than counting the bytes in between */
+	return a->hash == b->hash &&
+	       a->converted == b->converted &&
+	       a->stat.framed == b->stat.framed &&
+	       a->stat.valid == b->stat.valid &&
+	       !memcmp(&a->stat.drops[NMEA_DROP_OOB + 1], &b->stat.drops[NMEA_DROP_OOB + 1],
+	               sizeof(a->stat.drops) - sizeof(a->stat.drops[0]));
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	char              *log = malloc(LOG_LEN);
+	char              *work = malloc(LOG_LEN);
+	size_t            len;
+	struct result_t   ref_scan;
+	struct result_t   ref_convert;
+	struct result_t   result;
+	enum scan_impl_t  impl;
+	double            mb;
+
+	if (!log || !work) {
+		fprintf(stderr, "Error: out of memory\n");
+		return EXIT_FAILURE;
+	}
+	len = make_log(log, LOG_LEN);
+	mb  = len / 1e6;
+
+	run_bytes(none, log, len, &ref_scan);
+	run_bytes(convert, log, len, &ref_convert);
+	printf("%.1f MB, %lu sentences, %lu valid, %lu GPRMC converted\n", mb, ref_convert.stat.framed, ref_convert.stat.valid, ref_convert.converted);
+	printf("kernel    scan MB/s  convert MB/s\n");
+	printf("%-8s  %9.1f  %12.1f\n", "bytewise", mb / ref_scan.seconds, mb / ref_convert.seconds);
+
+	for (impl = SCAN_SCALAR; impl < SCAN_IMPLS; impl++) {
+		double  scan_s;
+
+		if (!scan_supported(impl)) {
+			printf("%-8s  not supported\n", scan_name(impl));
+			continue;
+		}
+		run_scan(impl, none, log, work, len, &result);
+		if (!same(&result, &ref_scan)) {
+			fprintf(stderr, "Error: %s scan differs from the bytewise reference\n", scan_name(impl));
+			return EXIT_FAILURE;
+		}
+		scan_s = result.seconds;
+		run_scan(impl, convert, log, work, len, &result);
+		if (!same(&result, &ref_convert)) {
+			fprintf(stderr, "Error: %s conversion differs from the bytewise reference\n", scan_name(impl));
+			return EXIT_FAILURE;
+		}
+		printf("%-8s  %9.1f  %12.1f\n", scan_name(impl), mb / scan_s, mb / result.seconds);
+	}
+
+	free(work);
+	free(log);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1 @@
+../digits.c
\ No newline at end of file
@@ -0,0 +1 @@
+../digits.h
\ No newline at end of file
@@ -0,0 +1 @@
+../event.h
\ No newline at end of file
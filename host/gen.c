@@ -0,0 +1,78 @@
+/******************************************************************************/
+/* File    : gen.c                                                            */
+/* Function: Synthetic NMEA streams for testing and benchmarking              */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Sentence n is the GPRMC of n seconds after 25 March 2017 23:00:00 UTC,     */
+/* so a stream starts an hour before a DST switch-over. Every fourth epoch    */
+/* is preceded by a GPGGA, which a converter should skip.                     */
+/******************************************************************************/
+#include <stdio.h>
+
+#include "rtc.h"
+
+#include "gen.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define GEN_START               (1490482800UL - UNIX_EPOCH_OFFSET)
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static size_t finish(char *buf, int len)
+{
+	unsigned char  sum = 0;
+	int            ndx;
+
+	for (ndx = 1; ndx < len; ndx++)
+		sum ^= (unsigned char)buf[ndx];
+
+	return len + sprintf(&buf[len], "*%02X\r\n", sum);
+}
+
+
+static size_t gen_gga(char *buf, unsigned long n)
+{
+	struct rtctime_t  utc;
+
+	rtc_secs2time((rtcsecs_t)(GEN_START + n), &utc);
+
+	return finish(buf, sprintf(buf, "$GPGGA,%02u%02u%02u,5213.0000,N,00600.0000,E,1,08,1.0,10.0,M,46.0,M,,",
+	                           utc.hour, utc.min, utc.sec));
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/* Writes the n-th GPRMC sentence into buf, which must hold GEN_LEN_MAX bytes */
+size_t gen_rmc(char *buf, unsigned long n)
+{
+	struct rtctime_t  utc;
+
+	rtc_secs2time((rtcsecs_t)(GEN_START + n), &utc);
+
+	return finish(buf, sprintf(buf, "$GPRMC,%02u%02u%02u,A,5213.0000,N,00600.0000,E,0.0,0.0,%02u%02u%02u,003.1,W",
+	                           utc.hour, utc.min, utc.sec, utc.day, utc.mon + 1, utc.year % 100));
+}
+
+
+/* Fills buf with whole sentences of epoch *n up to end, returns the number of bytes and advances *n */
+size_t gen_stream(char *buf, size_t size, unsigned long *n, unsigned long end)
+{
+	size_t  len = 0;
+
+	while (*n < end && size - len >= 2 * GEN_LEN_MAX) {
+		if (*n % 4 == 0)
+			len += gen_gga(&buf[len], *n);
+		len += gen_rmc(&buf[len], *n);
+		(*n)++;
+	}
+
+	return len;
+}
@@ -0,0 +1,30 @@
+/******************************************************************************/
+/* File    : gen.h                                                            */
+/* Function: Header file of 'gen.c'                                           */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef GEN_H
+#define GEN_H
+
+#include <stddef.h>
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define GEN_LEN_MAX             83      /* Longest generated sentence, including the 0-termination */
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+size_t gen_rmc   (char           *buf,
+                  unsigned long  n);
+size_t gen_stream(char           *buf,
+                  size_t         size,
+                  unsigned long  *n,
+                  unsigned long  end);
+
+
+#endif /* GEN_H */
@@ -0,0 +1 @@
+../nmeactx.h
\ No newline at end of file
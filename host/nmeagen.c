@@ -0,0 +1,89 @@
+/******************************************************************************/
+/* File    : nmeagen.c                                                        */
+/* Function: Writes a synthetic NMEA stream to stdout                         */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Without options, writes as fast as the output accepts. With -r, writes    */
+/* that many epochs per second, to feed a gateway or a unit in real time.     */
+/******************************************************************************/
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gen.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define CHUNK_LEN               65536
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n epochs] [-r epochs per second]\n", name);
+}
+
+
+static int write_all(const char *buf, size_t len)
+{
+	while (len) {
+		ssize_t  written = write(STDOUT_FILENO, buf, len);
+
+		if (written <= 0)
+			return -1;
+		buf += written;
+		len -= written;
+	}
+
+	return 0;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	static char    buf[CHUNK_LEN];
+	unsigned long  epochs = ULONG_MAX;
+	unsigned long  rate = 0;            /* 0 for unlimited */
+	unsigned long  n = 0;
+	int            opt;
+
+	while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			epochs = strtoul(optarg, NULL, 10);
+			break;
+		case 'r':
+			rate = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	while (n < epochs) {
+		/* One epoch at a time when rate limited */
+		size_t  len = gen_stream(buf, rate ? 2 * GEN_LEN_MAX : sizeof(buf), &n, epochs);
+
+		if (rate) {
+			struct timespec  delay = { 0, 1000000000L / rate };
+
+			nanosleep(&delay, NULL);
+		}
+		if (write_all(buf, len))
+			return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,445 @@
+/******************************************************************************/
+/* File    : nmeagw.c                                                         */
+/* Function: Multi-stream NMEA local time gateway                             */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Does what the firmware does for any number of inputs at once: each input  */
+/* (a serial port, a pty, a FIFO, ...) gets its own parser context and its   */
+/* own output pty, to which the GPRMC sentences are written in local time.    */
+/* The inputs are spread over a number of threads, each running an epoll     */
+/* loop of its own. As on the PIC, output that can't be written right away   */
+/* is dropped rather than queued.                                             */
+/*                                                                            */
+/* With -B, the gateway benchmarks itself on pipes fed by synthetic streams  */
+/* instead of opening devices and ptys.                                       */
+/******************************************************************************/
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nmeactx.h"
+#include "lt.h"
+#include "gen.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define THREADS_MAX             64
+#define STREAMS_MAX             1024
+#define READ_LEN                4096    /* Bytes read at once */
+#define READS_PER_EVENT         4       /* Reads per ready stream before serving the next, for fairness */
+#define EVENTS_MAX              64
+#define POLL_MS                 200     /* Longest time before noticing a stop request */
+#define DEFAULT_BITRATE         4800
+#define DEFAULT_BENCH_S         5
+#define GEN_CHUNK_LEN           65536
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct stream_t {
+	const char          *name;
+	int                 in_fd;
+	int                 out_fd;
+	int                 gen_fd;         /* Benchmark only: write end of the input */
+	int                 drain_fd;       /* Benchmark only: read end of the output */
+	char                out_name[64];
+	struct nmea_ctx_t   ctx;
+	unsigned long long  bytes_in;
+	unsigned long       converted;
+	unsigned long       dropped;        /* Sentences that couldn't be written (completely) */
+};
+
+struct worker_t {
+	pthread_t           thread;
+	pthread_t           gen_thread;     /* Benchmark only */
+	unsigned int        ndx;
+	int                 epfd;
+	unsigned int        streams;        /* Streams still open */
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static const struct nmea_t     nmea[] = {
+	{"GPRMC", handle_gprmc},
+	{NULL,    NULL}
+};
+
+static volatile sig_atomic_t  stop;
+static struct stream_t        streams[STREAMS_MAX];
+static unsigned int           stream_count;
+static struct worker_t        workers[THREADS_MAX];
+static unsigned int           worker_count;
+static char                   gen_buf[GEN_CHUNK_LEN];
+static size_t                 gen_len;
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct stream_t  *stream = ctx->user;
+	rtcsecs_t        utc_secs;
+	unsigned char    dst;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+
+	if (lt_gprmc(NULL, argc, argv, &utc_secs, &dst))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+
+	if (write(stream->out_fd, sentence, len) == len)
+		stream->converted++;
+	else
+		stream->dropped++;
+}
+
+
+static void on_signal(int sig)
+{
+	stop = 1;
+}
+
+
+static speed_t bitrate2speed(unsigned long bitrate)
+{
+	switch (bitrate) {
+	case 4800:   return B4800;
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+
+static int open_input(struct stream_t *stream, speed_t speed)
+{
+	struct termios  tio;
+
+	if ((stream->in_fd = open(stream->name, O_RDONLY | O_NOCTTY | O_NONBLOCK)) < 0)
+		return -1;
+
+	if (isatty(stream->in_fd)) {
+		if (tcgetattr(stream->in_fd, &tio) < 0)
+			return -1;
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		if (tcsetattr(stream->in_fd, TCSANOW, &tio) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+static int open_output(struct stream_t *stream)
+{
+	struct termios  tio;
+
+	if ((stream->out_fd = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK)) < 0)
+		return -1;
+	if (grantpt(stream->out_fd) < 0 ||
+	    unlockpt(stream->out_fd) < 0 ||
+	    ptsname_r(stream->out_fd, stream->out_name, sizeof(stream->out_name)))
+		return -1;
+
+	/* Pass the sentences on as they are, no CR/LF translation nor echo */
+	if (tcgetattr(stream->out_fd, &tio) < 0)
+		return -1;
+	cfmakeraw(&tio);
+	if (tcsetattr(stream->out_fd, TCSANOW, &tio) < 0)
+		return -1;
+
+	return 0;
+}
+
+
+static int open_bench(struct stream_t *stream)
+{
+	int  in[2];
+	int  out[2];
+
+	if (pipe2(in, O_NONBLOCK) < 0 || pipe2(out, O_NONBLOCK) < 0)
+		return -1;
+	stream->in_fd    = in[0];
+	stream->gen_fd   = in[1];
+	stream->out_fd   = out[1];
+	stream->drain_fd = out[0];
+	snprintf(stream->out_name, sizeof(stream->out_name), "pipe:[%d]", out[1]);
+
+	/* The generator blocks rather than spins when the gateway can't keep up */
+	return fcntl(stream->gen_fd, F_SETFL, 0);
+}
+
+
+static void *worker_run(void *arg)
+{
+	struct worker_t     *worker = arg;
+	struct epoll_event  ev[EVENTS_MAX];
+	char                buf[READ_LEN];
+	int                 count;
+	int                 ndx;
+
+	while (!stop && worker->streams) {
+		if ((count = epoll_wait(worker->epfd, ev, EVENTS_MAX, POLL_MS)) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("epoll_wait");
+			break;
+		}
+		for (ndx = 0; ndx < count; ndx++) {
+			struct stream_t  *stream = ev[ndx].data.ptr;
+			unsigned int     reads;
+
+			for (reads = 0; reads < READS_PER_EVENT; reads++) {
+				ssize_t  len = read(stream->in_fd, buf, sizeof(buf));
+				ssize_t  pos;
+
+				if (len > 0) {
+					stream->bytes_in += len;
+					for (pos = 0; pos < len; pos++)
+						nmea_ctx_char(&stream->ctx, buf[pos]);
+					continue;
+				}
+				if (len < 0 && (errno == EAGAIN || errno == EINTR))
+					break;
+
+				/* End of file, or the device went away */
+				epoll_ctl(worker->epfd, EPOLL_CTL_DEL, stream->in_fd, NULL);
+				close(stream->in_fd);
+				stream->in_fd = -1;
+				worker->streams--;
+				fprintf(stderr, "%s: closed\n", stream->name);
+				break;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+
+/* Benchmark only: keeps the inputs of one worker's streams filled */
+static void *gen_run(void *arg)
+{
+	struct worker_t  *worker = arg;
+	unsigned int     ndx;
+
+	while (!stop) {
+		for (ndx = worker->ndx; ndx < stream_count; ndx += worker_count) {
+			if (write(streams[ndx].gen_fd, gen_buf, gen_len) < 0)
+				return NULL;
+		}
+	}
+
+	return NULL;
+}
+
+
+/* Benchmark only: empties the outputs, as a consumer would */
+static void *drain_run(void *arg)
+{
+	struct epoll_event  ev[EVENTS_MAX];
+	char                buf[READ_LEN];
+	int                 epfd = *(int *)arg;
+	int                 count;
+	int                 ndx;
+
+	while (!stop) {
+		if ((count = epoll_wait(epfd, ev, EVENTS_MAX, POLL_MS)) < 0)
+			continue;
+		for (ndx = 0; ndx < count; ndx++)
+			while (read(ev[ndx].data.fd, buf, sizeof(buf)) > 0);
+	}
+
+	return NULL;
+}
+
+
+static double now_s(void)
+{
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-t threads] [-b bitrate] input ...\n"
+	                "       %s [-t threads] -B streams [-d seconds]\n", name, name);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	unsigned long       bitrate = DEFAULT_BITRATE;
+	unsigned int        bench = 0;      /* Number of synthetic streams, 0 for none */
+	unsigned int        duration = DEFAULT_BENCH_S;
+	long                cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	speed_t             speed;
+	pthread_t           drain_thread;
+	int                 drain_epfd = -1;
+	unsigned long long  bytes = 0;
+	unsigned long       converted = 0;
+	unsigned long       dropped = 0;
+	double              start;
+	double              elapsed;
+	unsigned int        ndx;
+	int                 opt;
+
+	worker_count = (cpus > 0 && cpus < THREADS_MAX) ? (unsigned int)cpus : 1;
+	while ((opt = getopt(argc, argv, "t:b:B:d:h")) != -1) {
+		switch (opt) {
+		case 't':
+			worker_count = strtoul(optarg, NULL, 10);
+			break;
+		case 'b':
+			bitrate = strtoul(optarg, NULL, 10);
+			break;
+		case 'B':
+			bench = strtoul(optarg, NULL, 10);
+			break;
+		case 'd':
+			duration = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	stream_count = bench ? bench : (unsigned int)(argc - optind);
+	if (!stream_count || stream_count > STREAMS_MAX || !worker_count || worker_count > THREADS_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if ((speed = bitrate2speed(bitrate)) == B0) {
+		fprintf(stderr, "Error: unsupported bit rate %lu\n", bitrate);
+		return EXIT_FAILURE;
+	}
+	if (worker_count > stream_count)
+		worker_count = stream_count;
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+
+	for (ndx = 0; ndx < worker_count; ndx++) {
+		workers[ndx].ndx = ndx;
+		if ((workers[ndx].epfd = epoll_create1(0)) < 0) {
+			perror("epoll_create1");
+			return EXIT_FAILURE;
+		}
+	}
+	if (bench) {
+		unsigned long  n = 0;
+
+		gen_len = gen_stream(gen_buf, sizeof(gen_buf), &n, ULONG_MAX);
+		if ((drain_epfd = epoll_create1(0)) < 0) {
+			perror("epoll_create1");
+			return EXIT_FAILURE;
+		}
+	}
+
+	/* Open all streams and hand them out to the workers round-robin */
+	for (ndx = 0; ndx < stream_count; ndx++) {
+		struct stream_t     *stream = &streams[ndx];
+		struct worker_t     *worker = &workers[ndx % worker_count];
+		struct epoll_event  ev;
+
+		nmea_ctx_init(&stream->ctx, nmea, stream);
+		if (bench) {
+			stream->name = "synthetic";
+			if (open_bench(stream) < 0) {
+				perror("pipe");
+				return EXIT_FAILURE;
+			}
+			ev.events  = EPOLLIN;
+			ev.data.fd = stream->drain_fd;
+			epoll_ctl(drain_epfd, EPOLL_CTL_ADD, stream->drain_fd, &ev);
+		} else {
+			stream->name = argv[optind + ndx];
+			if (open_input(stream, speed) < 0 || open_output(stream) < 0) {
+				fprintf(stderr, "Error: cannot open %s: %s\n", stream->name, strerror(errno));
+				return EXIT_FAILURE;
+			}
+			printf("%s -> %s\n", stream->name, stream->out_name);
+		}
+
+		ev.events   = EPOLLIN;
+		ev.data.ptr = stream;
+		if (epoll_ctl(worker->epfd, EPOLL_CTL_ADD, stream->in_fd, &ev) < 0) {
+			fprintf(stderr, "Error: cannot poll %s: %s\n", stream->name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+		worker->streams++;
+	}
+	fflush(stdout);
+
+	start = now_s();
+	for (ndx = 0; ndx < worker_count; ndx++)
+		pthread_create(&workers[ndx].thread, NULL, worker_run, &workers[ndx]);
+	if (bench) {
+		pthread_create(&drain_thread, NULL, drain_run, &drain_epfd);
+		for (ndx = 0; ndx < worker_count; ndx++)
+			pthread_create(&workers[ndx].gen_thread, NULL, gen_run, &workers[ndx]);
+		sleep(duration);
+		stop = 1;
+	}
+
+	for (ndx = 0; ndx < worker_count; ndx++)
+		pthread_join(workers[ndx].thread, NULL);
+	elapsed = now_s() - start;
+	if (bench) {
+		/* Closing the inputs makes blocked generators return */
+		for (ndx = 0; ndx < stream_count; ndx++)
+			close(streams[ndx].in_fd);
+		for (ndx = 0; ndx < worker_count; ndx++)
+			pthread_join(workers[ndx].gen_thread, NULL);
+		pthread_join(drain_thread, NULL);
+	}
+
+	for (ndx = 0; ndx < stream_count; ndx++) {
+		struct stream_t  *stream = &streams[ndx];
+
+		if (!bench)
+			fprintf(stderr, "%s: %llu bytes in, %lu/%lu sentences valid, %lu converted, %lu dropped\n",
+			        stream->name, stream->bytes_in, stream->ctx.stat.valid, stream->ctx.stat.framed, stream->converted, stream->dropped);
+		bytes     += stream->bytes_in;
+		converted += stream->converted;
+		dropped   += stream->dropped;
+	}
+	if (bench)
+		printf("%u streams, %u threads: %.1f MB/s in, %.0f GPRMC/s converted, %lu dropped\n",
+		       stream_count, worker_count, bytes / elapsed / 1e6, converted / elapsed, dropped);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,308 @@
+/******************************************************************************/
+/* File    : nmealog.c                                                        */
+/* Function: Multi-threaded conversion of NMEA logs to local time             */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Maps the input log into memory and cuts it into chunks right after a LF,   */
+/* where the parser is idle whatever came before, so converting the chunks    */
+/* independently gives the same result as converting the log in one go.      */
+/* Worker threads take chunks in turn and convert them with scan() and the    */
+/* GPRMC rewrite, the main thread writes their output in order. Like the      */
+/* firmware, only the converted GPRMC sentences are output.                   */
+/******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "nmeactx.h"
+#include "lt.h"
+#include "scan.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define THREADS_MAX             256
+#define CHUNK_LEN               (8UL << 20)  /* Nominal chunk size */
+#define CHUNKS_AHEAD_PER_THREAD 4            /* Limits the output held in memory */
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct chunk_t {
+	char                *out;
+	size_t              out_len;
+	struct nmea_stat_t  stat;
+	int                 done;
+};
+
+struct worker_t {
+	pthread_t           thread;
+	char                *work;          /* Copy of the chunk, as scan() works in place */
+	size_t              work_size;
+	char                *out;           /* Output of the chunk being converted */
+	size_t              out_len;
+	size_t              out_size;
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static const struct nmea_t  nmea[] = {
+	{"GPRMC", handle_gprmc},
+	{NULL,    NULL}
+};
+
+static const char           *in;
+static size_t               in_len;
+static size_t               chunk_count;
+static struct chunk_t       *chunks;
+static size_t               next_chunk;     /* Next chunk to be taken by a worker */
+static size_t               written;        /* Chunks written so far */
+static size_t               ahead;          /* Maximum number of chunks converted but not written */
+static enum scan_impl_t     impl;
+static pthread_mutex_t      lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t       cond = PTHREAD_COND_INITIALIZER;
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void out_of_memory(void)
+{
+	fprintf(stderr, "Error: out of memory\n");
+	exit(EXIT_FAILURE);
+}
+
+
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct worker_t  *worker = ctx->user;
+	rtcsecs_t        utc_secs;
+	unsigned char    dst;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+
+	if (lt_gprmc(NULL, argc, argv, &utc_secs, &dst))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+
+	/* Rarely needed: a CR is added to sentences terminated by a LF only */
+	if (worker->out_len + len > worker->out_size) {
+		worker->out_size *= 2;
+		if ((worker->out = realloc(worker->out, worker->out_size)) == NULL)
+			out_of_memory();
+	}
+	memcpy(&worker->out[worker->out_len], sentence, len);
+	worker->out_len += len;
+}
+
+
+/* Start of the chunk that nominally starts at pos: just past the first LF from there */
+static size_t chunk_start(size_t pos)
+{
+	const char  *lf;
+
+	if (pos == 0)
+		return 0;
+	if (pos >= in_len)
+		return in_len;
+	lf = memchr(&in[pos - 1], '\n', in_len - (pos - 1));
+
+	return lf ? (size_t)(lf - in) + 1 : in_len;
+}
+
+
+static void *worker_run(void *arg)
+{
+	struct worker_t    *worker = arg;
+	struct nmea_ctx_t  ctx;
+
+	for (;;) {
+		size_t  ndx;
+		size_t  start;
+		size_t  end;
+
+		pthread_mutex_lock(&lock);
+		while (next_chunk < chunk_count && next_chunk >= written + ahead)
+			pthread_cond_wait(&cond, &lock);
+		ndx = next_chunk++;
+		pthread_mutex_unlock(&lock);
+		if (ndx >= chunk_count)
+			return NULL;
+
+		start = chunk_start(ndx * CHUNK_LEN);
+		end   = chunk_start((ndx + 1) * CHUNK_LEN);
+		if (end - start > worker->work_size) {
+			worker->work_size = end - start;
+			if ((worker->work = realloc(worker->work, worker->work_size)) == NULL)
+				out_of_memory();
+		}
+		worker->out_size = end - start + NMEA_LEN_MAX;
+		worker->out_len  = 0;
+		if ((worker->out = malloc(worker->out_size)) == NULL)
+			out_of_memory();
+		nmea_ctx_init(&ctx, nmea, worker);
+		memcpy(worker->work, &in[start], end - start);
+		scan(impl, &ctx, worker->work, end - start);
+
+		pthread_mutex_lock(&lock);
+		chunks[ndx].out     = worker->out;
+		chunks[ndx].out_len = worker->out_len;
+		chunks[ndx].stat    = ctx.stat;
+		chunks[ndx].done    = 1;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+	}
+}
+
+
+static int write_all(int fd, const char *buf, size_t len)
+{
+	while (len) {
+		ssize_t  count = write(fd, buf, len);
+
+		if (count <= 0)
+			return -1;
+		buf += count;
+		len -= count;
+	}
+
+	return 0;
+}
+
+
+static double now_s(void)
+{
+	struct timespec  ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-t threads] [-s scalar|sse2|avx2] input [output]\n", name);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	static struct worker_t  workers[THREADS_MAX];
+	long                    cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	unsigned int            thread_count = (cpus > 0 && cpus < THREADS_MAX) ? (unsigned int)cpus : 1;
+	unsigned long           framed = 0;
+	unsigned long           valid = 0;
+	unsigned long long      out_total = 0;
+	struct stat             st;
+	double                  start;
+	double                  elapsed;
+	int                     in_fd;
+	int                     out_fd = STDOUT_FILENO;
+	unsigned int            ndx;
+	int                     opt;
+
+	impl = scan_best();
+	while ((opt = getopt(argc, argv, "t:s:h")) != -1) {
+		switch (opt) {
+		case 't':
+			thread_count = strtoul(optarg, NULL, 10);
+			break;
+		case 's':
+			for (impl = SCAN_SCALAR; impl < SCAN_IMPLS; impl++)
+				if (!strcmp(optarg, scan_name(impl)))
+					break;
+			if (impl >= SCAN_IMPLS || !scan_supported(impl)) {
+				fprintf(stderr, "Error: unsupported kernel %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc || argc - optind > 2 || !thread_count || thread_count > THREADS_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if ((in_fd = open(argv[optind], O_RDONLY)) < 0 || fstat(in_fd, &st) < 0) {
+		fprintf(stderr, "Error: cannot open %s: %s\n", argv[optind], strerror(errno));
+		return EXIT_FAILURE;
+	}
+	if (argc - optind == 2 &&
+	    (out_fd = open(argv[optind + 1], O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+		fprintf(stderr, "Error: cannot open %s: %s\n", argv[optind + 1], strerror(errno));
+		return EXIT_FAILURE;
+	}
+	in_len = st.st_size;
+	if (in_len == 0)
+		return EXIT_SUCCESS;
+	if ((in = mmap(NULL, in_len, PROT_READ, MAP_PRIVATE, in_fd, 0)) == MAP_FAILED) {
+		perror("mmap");
+		return EXIT_FAILURE;
+	}
+	madvise((void *)in, in_len, MADV_SEQUENTIAL);
+
+	chunk_count = (in_len + CHUNK_LEN - 1) / CHUNK_LEN;
+	ahead       = thread_count * CHUNKS_AHEAD_PER_THREAD;
+	if ((chunks = calloc(chunk_count, sizeof(*chunks))) == NULL)
+		out_of_memory();
+
+	start = now_s();
+	for (ndx = 0; ndx < thread_count; ndx++)
+		pthread_create(&workers[ndx].thread, NULL, worker_run, &workers[ndx]);
+
+	/* Write the output of the chunks in order, as they complete */
+	for (written = 0; written < chunk_count; ) {
+		struct chunk_t  *chunk = &chunks[written];
+
+		pthread_mutex_lock(&lock);
+		while (!chunk->done)
+			pthread_cond_wait(&cond, &lock);
+		pthread_mutex_unlock(&lock);
+
+		if (write_all(out_fd, chunk->out, chunk->out_len)) {
+			perror("write");
+			return EXIT_FAILURE;
+		}
+		framed    += chunk->stat.framed;
+		valid     += chunk->stat.valid;
+		out_total += chunk->out_len;
+		free(chunk->out);
+
+		pthread_mutex_lock(&lock);
+		written++;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+	}
+
+	for (ndx = 0; ndx < thread_count; ndx++) {
+		pthread_join(workers[ndx].thread, NULL);
+		free(workers[ndx].work);
+	}
+	elapsed = now_s() - start;
+
+	fprintf(stderr, "%.1f MB in, %.1f MB out, %lu sentences, %lu valid, %u threads (%s): %.1f MB/s\n",
+	        in_len / 1e6, out_total / 1e6, framed, valid, thread_count, scan_name(impl), in_len / elapsed / 1e6);
+
+	return EXIT_SUCCESS;
+}
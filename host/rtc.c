@@ -0,0 +1 @@
+../rtc.c
\ No newline at end of file
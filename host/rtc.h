@@ -0,0 +1 @@
+../rtc.h
\ No newline at end of file
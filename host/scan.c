@@ -0,0 +1,303 @@
+/******************************************************************************/
+/* File    : scan.c                                                           */
+/* Function: Bulk NMEA sentence scanner with SIMD kernels                     */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Finds the sentences in a buffer, verifies their checksums and hands them  */
+/* to nmea_ctx_dispatch(), with the same outcome as feeding the buffer to     */
+/* nmea_ctx_char() byte by byte: a sentence runs from '$' up to the first     */
+/* CR or LF, and is dropped when it holds a NMEA_LOST, or once it exceeds the */
+/* maximum length, after which the next '$' is searched for. Searching for    */
+/* '$' and the line terminators and computing the XOR checksum are done 16    */
+/* (SSE2) or 32 (AVX2) bytes at a time; the scalar kernels are the reference. */
+/* Drops are counted by reason the same way, except for out-of-band bytes.    */
+/******************************************************************************/
+#include <stdint.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "digits.h"
+
+#include "scan.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define SENTENCE_LEN_MAX        (NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN)  /* A sentence is dropped when it reaches this length, see nmea_ctx_char() */
+
+#define ctz(x)                  ((unsigned int)__builtin_ctz(x))
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct kernel_t {
+	const char     *name;
+	size_t         (*find_header)(const char *buf, size_t len);   /* Index of the first '$', or len */
+	size_t         (*find_trailer)(const char *buf, size_t len);  /* Index of the first CR or LF, or len */
+	unsigned char  (*checksum)(const char *buf, size_t len);
+};
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static size_t find_header_scalar(const char *buf, size_t len)
+{
+	const char  *found = memchr(buf, NMEA_HEADER, len);
+
+	return found ? (size_t)(found - buf) : len;
+}
+
+
+static size_t find_trailer_scalar(const char *buf, size_t len)
+{
+	size_t  ndx;
+
+	for (ndx = 0; ndx < len; ndx++)
+		if (buf[ndx] == '\r' || buf[ndx] == '\n')
+			break;
+
+	return ndx;
+}
+
+
+static unsigned char checksum_scalar(const char *buf, size_t len)
+{
+	unsigned char  sum = 0;
+	size_t         ndx;
+
+	for (ndx = 0; ndx < len; ndx++)
+		sum ^= (unsigned char)buf[ndx];
+
+	return sum;
+}
+
+
+static size_t find_header_sse2(const char *buf, size_t len)
+{
+	const __m128i  header = _mm_set1_epi8(NMEA_HEADER);
+	size_t         ndx;
+
+	for (ndx = 0; ndx + 16 <= len; ndx += 16) {
+		__m128i   data = _mm_loadu_si128((const __m128i *)&buf[ndx]);
+		unsigned  mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(data, header));
+
+		if (mask)
+			return ndx + ctz(mask);
+	}
+
+	return ndx + find_header_scalar(&buf[ndx], len - ndx);
+}
+
+
+static size_t find_trailer_sse2(const char *buf, size_t len)
+{
+	const __m128i  cr = _mm_set1_epi8('\r');
+	const __m128i  lf = _mm_set1_epi8('\n');
+	size_t         ndx;
+
+	for (ndx = 0; ndx + 16 <= len; ndx += 16) {
+		__m128i   data = _mm_loadu_si128((const __m128i *)&buf[ndx]);
+		unsigned  mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(data, cr),
+		                                                          _mm_cmpeq_epi8(data, lf)));
+
+		if (mask)
+			return ndx + ctz(mask);
+	}
+
+	return ndx + find_trailer_scalar(&buf[ndx], len - ndx);
+}
+
+
+/* Folds the 16 lanes of an XOR accumulator into one byte */
+static unsigned char fold_sse2(__m128i acc)
+{
+	acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 8));
+	acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 4));
+	acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 2));
+	acc = _mm_xor_si128(acc, _mm_srli_si128(acc, 1));
+
+	return (unsigned char)_mm_cvtsi128_si32(acc);
+}
+
+
+static unsigned char checksum_sse2(const char *buf, size_t len)
+{
+	__m128i  acc = _mm_setzero_si128();
+	size_t   ndx;
+
+	for (ndx = 0; ndx + 16 <= len; ndx += 16)
+		acc = _mm_xor_si128(acc, _mm_loadu_si128((const __m128i *)&buf[ndx]));
+
+	return fold_sse2(acc) ^ checksum_scalar(&buf[ndx], len - ndx);
+}
+
+
+__attribute__((target("avx2")))
+static size_t find_header_avx2(const char *buf, size_t len)
+{
+	const __m256i  header = _mm256_set1_epi8(NMEA_HEADER);
+	size_t         ndx;
+
+	for (ndx = 0; ndx + 32 <= len; ndx += 32) {
+		__m256i   data = _mm256_loadu_si256((const __m256i *)&buf[ndx]);
+		unsigned  mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(data, header));
+
+		if (mask)
+			return ndx + ctz(mask);
+	}
+
+	return ndx + find_header_scalar(&buf[ndx], len - ndx);
+}
+
+
+__attribute__((target("avx2")))
+static size_t find_trailer_avx2(const char *buf, size_t len)
+{
+	const __m256i  cr = _mm256_set1_epi8('\r');
+	const __m256i  lf = _mm256_set1_epi8('\n');
+	size_t         ndx;
+
+	for (ndx = 0; ndx + 32 <= len; ndx += 32) {
+		__m256i   data = _mm256_loadu_si256((const __m256i *)&buf[ndx]);
+		unsigned  mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(data, cr),
+		                                                                _mm256_cmpeq_epi8(data, lf)));
+
+		if (mask)
+			return ndx + ctz(mask);
+	}
+
+	return ndx + find_trailer_scalar(&buf[ndx], len - ndx);
+}
+
+
+__attribute__((target("avx2")))
+static unsigned char checksum_avx2(const char *buf, size_t len)
+{
+	__m256i  acc = _mm256_setzero_si256();
+	__m128i  half;
+	size_t   ndx;
+
+	for (ndx = 0; ndx + 32 <= len; ndx += 32)
+		acc = _mm256_xor_si256(acc, _mm256_loadu_si256((const __m256i *)&buf[ndx]));
+
+	/* Fold in VEX-encoded code; calling the SSE2 kernels from here would cost an AVX-SSE transition */
+	half = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+	half = _mm_xor_si128(half, _mm_srli_si128(half, 8));
+	half = _mm_xor_si128(half, _mm_srli_si128(half, 4));
+	half = _mm_xor_si128(half, _mm_srli_si128(half, 2));
+	half = _mm_xor_si128(half, _mm_srli_si128(half, 1));
+
+	return (unsigned char)_mm_cvtsi128_si32(half) ^ checksum_scalar(&buf[ndx], len - ndx);
+}
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static const struct kernel_t  kernels[SCAN_IMPLS] = {
+	{"scalar", find_header_scalar, find_trailer_scalar, checksum_scalar},
+	{"sse2",   find_header_sse2,   find_trailer_sse2,   checksum_sse2},
+	{"avx2",   find_header_avx2,   find_trailer_avx2,   checksum_avx2}
+};
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int scan_supported(enum scan_impl_t impl)
+{
+	switch (impl) {
+	case SCAN_SCALAR:
+	case SCAN_SSE2:                     /* Part of x86_64 */
+		return 1;
+	case SCAN_AVX2:
+		return __builtin_cpu_supports("avx2");
+	default:
+		return 0;
+	}
+}
+
+
+enum scan_impl_t scan_best(void)
+{
+	return scan_supported(SCAN_AVX2) ? SCAN_AVX2 : SCAN_SSE2;
+}
+
+
+const char *scan_name(enum scan_impl_t impl)
+{
+	return kernels[impl].name;
+}
+
+
+/*
+ * Processes all complete sentences in buf, which is modified in place.
+ * Returns the number of bytes consumed: anything from there on is the start
+ * of a sentence that continues in the next buffer.
+ */
+size_t scan(enum scan_impl_t impl, struct nmea_ctx_t *ctx, char *buf, size_t len)
+{
+	const struct kernel_t  *kernel = &kernels[impl];
+	size_t                 pos = 0;
+
+	for (;;) {
+		size_t         start;
+		size_t         window;
+		size_t         end;
+		char           *sentence;
+		unsigned char  checksum;
+
+		/* Hunt for the header */
+		if ((start = pos + kernel->find_header(&buf[pos], len - pos)) >= len)
+			return len;
+		sentence = &buf[start + NMEA_HEADER_LEN];
+
+		/* Find the trailer within the maximum sentence length */
+		window = len - start - NMEA_HEADER_LEN;
+		if (window > SENTENCE_LEN_MAX)
+			window = SENTENCE_LEN_MAX;
+		if ((end = kernel->find_trailer(sentence, window)) >= window) {
+			if (window < SENTENCE_LEN_MAX)
+				/* Incomplete, leave it for the next buffer */
+				return start;
+			/* Over-sized, dropped */
+			ctx->stat.framed++;
+			ctx->stat.drops[NMEA_DROP_OVERSIZED]++;
+			pos = start + NMEA_HEADER_LEN + SENTENCE_LEN_MAX;
+			continue;
+		}
+		ctx->stat.framed++;
+		pos = start + NMEA_HEADER_LEN + end + 1;
+		if (memchr(sentence, NMEA_LOST, end)) {
+			ctx->stat.drops[NMEA_DROP_LOST]++;
+			continue;
+		}
+
+		/* Verify the checksum */
+		if (end < NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
+			ctx->stat.drops[NMEA_DROP_UNDERSIZED]++;
+			continue;
+		}
+		end -= NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN;
+		if (sentence[end] != '*') {
+			ctx->stat.drops[NMEA_DROP_NO_SEPARATOR]++;
+			continue;
+		}
+		if (digits_get_hex2(&sentence[end + NMEA_CHECKSUM_SEPARATOR_LEN], &checksum)) {
+			ctx->stat.drops[NMEA_DROP_BAD_HEX]++;
+			continue;
+		}
+		if (kernel->checksum(sentence, end) != checksum) {
+			ctx->stat.drops[NMEA_DROP_BAD_CHECKSUM]++;
+			continue;
+		}
+		ctx->stat.valid++;
+
+		sentence[end] = '\0';
+		nmea_ctx_dispatch(ctx, sentence);
+	}
+}
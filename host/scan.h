@@ -0,0 +1,38 @@
+/******************************************************************************/
+/* File    : scan.h                                                           */
+/* Function: Header file of 'scan.c'                                          */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef SCAN_H
+#define SCAN_H
+
+#include <stddef.h>
+
+#include "nmeactx.h"
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+enum scan_impl_t {
+	SCAN_SCALAR = 0,
+	SCAN_SSE2,
+	SCAN_AVX2,
+	SCAN_IMPLS
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+int              scan_supported(enum scan_impl_t   impl);
+enum scan_impl_t scan_best     (void);
+const char       *scan_name    (enum scan_impl_t   impl);
+size_t           scan          (enum scan_impl_t   impl,
+                                struct nmea_ctx_t  *ctx,
+                                char               *buf,
+                                size_t             len);
+
+
+#endif /* SCAN_H */
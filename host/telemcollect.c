@@ -0,0 +1,270 @@
+/******************************************************************************/
+/* File    : telemcollect.c                                                   */
+/* Function: Collects telemetry records from one or more units                */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Reads the console of any number of units (serial ports, or '-' for        */
+/* stdin), picks the $PCWET records out of whatever else is printed, checks  */
+/* their checksums and writes them to stdout as CSV, one line per record,     */
+/* prefixed with the host time and the unit. Gaps in the sequence numbers     */
+/* are reported on stderr.                                                    */
+/******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define LINE_LEN_MAX            82      /* Maximum NMEA sentence length, including '$' and trailer */
+#define UNITS_MAX               64
+#define RECORD_ADDRESS          "PCWET"
+#define RECORD_FIELDS           13      /* Including the address */
+#define DEFAULT_BITRATE         115200
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct unit_t {
+	const char     *name;
+	int            fd;
+	char           line[LINE_LEN_MAX + 1];
+	size_t         len;
+	int            have_seq;
+	unsigned long  seq;
+	unsigned long  records;
+	unsigned long  bad;                 /* Records with a bad checksum or field count */
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static struct unit_t  units[UNITS_MAX];
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static speed_t bitrate2speed(unsigned long bitrate)
+{
+	switch (bitrate) {
+	case 4800:   return B4800;
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+
+static int open_unit(const char *name, speed_t speed)
+{
+	struct termios  tio;
+	int             fd;
+
+	if (!strcmp(name, "-"))
+		return STDIN_FILENO;
+
+	if ((fd = open(name, O_RDONLY | O_NOCTTY)) < 0)
+		return -1;
+
+	if (isatty(fd)) {
+		if (tcgetattr(fd, &tio) < 0) {
+			close(fd);
+			return -1;
+		}
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, speed);
+		cfsetospeed(&tio, speed);
+		tio.c_cflag |= CLOCAL | CREAD;
+		if (tcsetattr(fd, TCSANOW, &tio) < 0) {
+			close(fd);
+			return -1;
+		}
+	}
+
+	return fd;
+}
+
+
+/* Checks a line of the form '$<data>*hh', returns the length of <data>, or -1 */
+static int check_sentence(const char *line, size_t len)
+{
+	unsigned char  sum = 0;
+	unsigned int   checksum;
+	size_t         ndx;
+
+	if (len < 4 || line[0] != '$' || line[len - 3] != '*')
+		return -1;
+	if (sscanf(&line[len - 2], "%2x", &checksum) != 1)
+		return -1;
+	for (ndx = 1; ndx < len - 3; ndx++)
+		sum ^= (unsigned char)line[ndx];
+
+	return (sum == checksum) ? (int)(len - 4) : -1;
+}
+
+
+static void proc_line(struct unit_t *unit)
+{
+	char            *field[RECORD_FIELDS];
+	char            *data = &unit->line[1];
+	int             data_len;
+	int             fields;
+	unsigned long   seq;
+	struct timespec now;
+	int             ndx;
+
+	if (strncmp(unit->line, "$" RECORD_ADDRESS ",", strlen(RECORD_ADDRESS) + 2))
+		return;
+
+	if ((data_len = check_sentence(unit->line, unit->len)) < 0) {
+		unit->bad++;
+		return;
+	}
+	data[data_len] = '\0';
+
+	/* Split into fields, empty ones included */
+	for (fields = 0; data && fields < RECORD_FIELDS; fields++)
+		field[fields] = strsep(&data, ",");
+	if (fields != RECORD_FIELDS || data) {
+		unit->bad++;
+		return;
+	}
+
+	seq = strtoul(field[1], NULL, 10);
+	if (unit->have_seq && seq != ((unit->seq + 1) & 0xffff))
+		fprintf(stderr, "%s: missed %lu record(s)\n", unit->name, (seq - unit->seq - 1) & 0xffff);
+	unit->have_seq = 1;
+	unit->seq      = seq;
+	unit->records++;
+
+	clock_gettime(CLOCK_REALTIME, &now);
+	printf("%ld.%03ld,%s", (long)now.tv_sec, now.tv_nsec / 1000000L, unit->name);
+	for (ndx = 1; ndx < RECORD_FIELDS; ndx++)
+		printf(",%s", field[ndx]);
+	printf("\n");
+	fflush(stdout);
+}
+
+
+static void proc_input(struct unit_t *unit, const char *buf, size_t len)
+{
+	size_t  ndx;
+
+	for (ndx = 0; ndx < len; ndx++) {
+		char  ch = buf[ndx];
+
+		if (ch == '$')
+			unit->len = 0;
+		if (ch == '\r' || ch == '\n') {
+			if (unit->len) {
+				unit->line[unit->len] = '\0';
+				proc_line(unit);
+			}
+			unit->len = 0;
+			continue;
+		}
+		/* Discard over-sized lines entirely */
+		if (unit->len >= LINE_LEN_MAX) {
+			unit->len = 0;
+			continue;
+		}
+		unit->line[unit->len++] = ch;
+	}
+}
+
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-b bitrate] device|- ...\n", name);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	struct pollfd  pfd[UNITS_MAX];
+	unsigned long  bitrate = DEFAULT_BITRATE;
+	speed_t        speed;
+	int            count = 0;
+	int            open_count;
+	int            opt;
+	int            ndx;
+
+	while ((opt = getopt(argc, argv, "b:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			bitrate = strtoul(optarg, NULL, 10);
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if (optind >= argc || argc - optind > UNITS_MAX) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	if ((speed = bitrate2speed(bitrate)) == B0) {
+		fprintf(stderr, "Error: unsupported bit rate %lu\n", bitrate);
+		return EXIT_FAILURE;
+	}
+
+	for (ndx = optind; ndx < argc; ndx++) {
+		struct unit_t  *unit = &units[count];
+
+		unit->name = argv[ndx];
+		if ((unit->fd = open_unit(unit->name, speed)) < 0) {
+			fprintf(stderr, "Error: cannot open %s: %s\n", unit->name, strerror(errno));
+			return EXIT_FAILURE;
+		}
+		pfd[count].fd     = unit->fd;
+		pfd[count].events = POLLIN;
+		count++;
+	}
+
+	printf("time,unit,seq,framed,valid,queued,dropped,rxerr,utc,offset,dst,drift,lat,latmax\n");
+
+	for (open_count = count; open_count > 0; ) {
+		if (poll(pfd, count, -1) < 0) {
+			if (errno == EINTR)
+				continue;
+			perror("poll");
+			return EXIT_FAILURE;
+		}
+		for (ndx = 0; ndx < count; ndx++) {
+			char     buf[256];
+			ssize_t  len;
+
+			if (!(pfd[ndx].revents & (POLLIN | POLLHUP | POLLERR)))
+				continue;
+			if ((len = read(pfd[ndx].fd, buf, sizeof(buf))) <= 0) {
+				/* End of file or a disappearing device: stop polling it */
+				fprintf(stderr, "%s: closed after %lu record(s), %lu bad\n", units[ndx].name, units[ndx].records, units[ndx].bad);
+				if (pfd[ndx].fd != STDIN_FILENO)
+					close(pfd[ndx].fd);
+				pfd[ndx].fd = -1;
+				open_count--;
+				continue;
+			}
+			proc_input(&units[ndx], buf, (size_t)len);
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+/******************************************************************************/
+/* File    : tracedec.c                                                       */
+/* Function: Decodes trace dumps of the firmware                              */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Reads captured console output (files, or stdin if none are given), picks  */
+/* the entries of the 'trace' command out of whatever else was printed and   */
+/* writes them as messages, using the event table in 'trace.h'. Time stamps   */
+/* are TMR1 ticks extended by its overflows to 32 bits, so the time between   */
+/* entries is printed as such up to 536 s. Entries overwritten before they    */
+/* were dumped show as gaps in the sequence numbers, reported on stderr.      */
+/******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "trace.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define LINE_LEN_MAX            256
+#define TICK_RANGE              0x100000000ULL  /* TMR1 and its overflow count are 16 bits each */
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+#define TRACE_NAME(id, message) #id,
+static const char  *names[TRACE_IDS] = {
+	TRACE_EVENTS(TRACE_NAME)
+};
+#undef TRACE_NAME
+
+#define TRACE_MESSAGE(id, message) message,
+static const char  *messages[TRACE_IDS] = {
+	TRACE_EVENTS(TRACE_MESSAGE)
+};
+#undef TRACE_MESSAGE
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void decode(FILE *in, const char *name)
+{
+	char           line[LINE_LEN_MAX];
+	int            have_prev = 0;
+	unsigned int   prev_seq = 0;
+	unsigned long  prev_tick = 0;
+	unsigned long  entries = 0;
+
+	while (fgets(line, sizeof(line), in)) {
+		const char    *tag = strstr(line, TRACE_TAG " ");
+		unsigned int  seq;
+		unsigned int  id;
+		unsigned int  arg;
+		unsigned long tick;
+
+		if (!tag || sscanf(tag + strlen(TRACE_TAG), "%2x %2x %2x %8lx", &seq, &id, &arg, &tick) != 4)
+			continue;
+
+		/* The sequence numbers start over after a reset */
+		if (id == TRACE_BOOT)
+			have_prev = 0;
+		if (have_prev && seq != ((prev_seq + 1) & 0xff)) {
+			if (((seq - prev_seq) & 0xff) == 0 || ((seq - prev_seq) & 0xff) >= 0x80)
+				/* Already decoded, from a dump without 'clear' */
+				continue;
+			fprintf(stderr, "%s: %u entries missing before sequence number %u\n", name, (seq - prev_seq - 1) & 0xff, seq);
+		}
+
+		if (have_prev)
+			printf("%3u  %10.3f ms  ", seq, ((tick - prev_tick) % TICK_RANGE) * 1000.0 / TRACE_TICK_HZ);
+		else
+			printf("%3u  %10s     ", seq, "");
+		if (id < TRACE_IDS) {
+			printf("%-24s ", names[id]);
+			printf(messages[id], arg);
+		} else
+			printf("Unknown event 0x%.2x (0x%.2x)", id, arg);
+		printf("\n");
+
+		have_prev = 1;
+		prev_seq  = seq;
+		prev_tick = tick;
+		entries++;
+	}
+
+	fprintf(stderr, "%s: %lu entries\n", name, entries);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	int  ndx;
+
+	if (argc < 2) {
+		decode(stdin, "stdin");
+		return EXIT_SUCCESS;
+	}
+
+	for (ndx = 1; ndx < argc; ndx++) {
+		FILE  *in;
+
+		if (!strcmp(argv[ndx], "-h")) {
+			fprintf(stderr, "Usage: %s [capture ...]\n", argv[0]);
+			return EXIT_FAILURE;
+		}
+		if ((in = fopen(argv[ndx], "r")) == NULL) {
+			perror(argv[ndx]);
+			return EXIT_FAILURE;
+		}
+		decode(in, argv[ndx]);
+		fclose(in);
+	}
+
+	return EXIT_SUCCESS;
+}
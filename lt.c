@@ -0,0 +1,304 @@
+/******************************************************************************/
+/* File    : lt.c                                                             */
+/* Function: Conversion of NMEA sentences from UTC to local time              */
+/* Author  : Robert Delien, agent                                             */
+/* Copyright (C) 2010, Clockwork Engineering                                  */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Works on the argument list of a sentence in place, keeping state only in a */
+/* struct lt_cache_t of the caller, so it's shared by the firmware and the    */
+/* host tools. The cache holds the last conversion, so the sentences of one   */
+/* epoch only cost one conversion between them. With LT_PREDICT, the next   */
+/* second is converted in idle time, so an epoch arriving on time costs none. */
+/******************************************************************************/
+#include <string.h>
+
+#include "digits.h"
+#include "trace.h"
+
+#include "lt.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define GPRMC_ARGS_MIN          10      /* Up to and including the date */
+#define GPGGA_ARGS_MIN          2       /* Up to and including the time */
+#define GPZDA_ARGS_MIN          5       /* Up to and including the year */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static int get_octets(const char *str, unsigned char *octet[])
+{
+	unsigned char  ndx;
+
+	/* Walk the given string, two digits at a time */
+	for (ndx = 0; ndx < 3; ndx++) {
+		/* Convert this part of the string to a numerical value, directly into the corresponding octet */
+		if (digits_get_dec2(&str[ndx << 1], octet[ndx])) {
+			TRACE(TRACE_LT_NUMBER, 0);
+			return -1;
+		}
+	}
+
+	/* Test for trailing garbage */
+	if (str[6] != '\0') {
+		TRACE(TRACE_LT_NUMBER, 0);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/* Get a field of exactly two digits */
+static int get_dec2(const char *str, unsigned char *value)
+{
+	if (digits_get_dec2(str, value) || str[2] != '\0') {
+		TRACE(TRACE_LT_NUMBER, 0);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static int get_time(const char *str, struct rtctime_t *utc)
+{
+	unsigned char  *octet[3];
+
+	octet[0] = &utc->hour;
+	octet[1] = &utc->min;
+	octet[2] = &utc->sec;
+
+	return get_octets(str, octet);
+}
+
+
+static void put_time(char *str, const struct rtctime_t *local)
+{
+	digits_put_dec2(&str[0], local->hour);
+	digits_put_dec2(&str[2], local->min);
+	digits_put_dec2(&str[4], local->sec);
+}
+
+
+/*
+ * Converts a broken-down UTC time to local time into the cache, unless the
+ * cache already holds it, or predicted it. Returns -1 if it isn't a proper
+ * time.
+ */
+static int convert(struct lt_cache_t *cache, struct rtctime_t *utc)
+{
+	struct lt_conv_t  *last = &cache->last;
+
+	if (cache->valid && !memcmp(&last->utc, utc, sizeof(*utc)))
+		return 0;
+	cache->valid = 0;
+
+#ifdef LT_PREDICT
+	/* A prediction is only good for the sentence following the last conversion */
+	if (cache->predicted) {
+		cache->predicted = 0;
+		if (!memcmp(&cache->next.utc, utc, sizeof(*utc))) {
+			*last        = cache->next;
+			cache->valid = 1;
+			cache->hits++;
+			return 0;
+		}
+	}
+#endif /* LT_PREDICT */
+
+	/* Convert broken-down UTC time to seconds and complete with weekday */
+	if (rtc_time2secs(utc, &last->utc_secs) < 0)
+		return -1;
+
+	/* Add local time offset and daylight saving time to UTC to get local time */
+	last->dst = rtc_dst_eu(utc, rtc_weekday(last->utc_secs));
+
+	/* Break down local time in seconds */
+	rtc_secs2time(last->utc_secs + lt_offset(last->dst), &last->local);
+
+	last->utc    = *utc;
+	cache->valid = 1;
+	cache->conversions++;
+
+	return 0;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/*
+ * Rewrites the time and date of a GPRMC sentence from UTC to local time.
+ * Returns 0 and the UTC time and DST state on success, or -1 if the sentence
+ * isn't valid or doesn't hold a proper time and date, leaving it untouched,
+ * and counting why in the cache. The cache may be NULL, to convert without
+ * one.
+ */
+int lt_gprmc(struct lt_cache_t *cache, int argc, char *argv[], rtcsecs_t *utc_secs, unsigned char *dst)
+{
+	struct lt_cache_t  scratch;
+	struct rtctime_t   utc;
+	unsigned char      *octet[3];
+
+	if (!cache) {
+		memset(&scratch, 0, sizeof(scratch));
+		cache = &scratch;
+	}
+
+	if (argc < GPRMC_ARGS_MIN) {
+		cache->rejected.args++;
+		return -1;
+	}
+
+	/* Check validity mark */
+	if (strcmp(argv[2], "A")) {
+		cache->rejected.status++;
+		return -1;
+	}
+
+	/* Get the 3 octets holding the time from the time argument */
+	if (get_time(argv[1], &utc)) {
+		cache->rejected.number++;
+		return -1;
+	}
+
+	/* Get the 3 octets holding the date from the date argument */
+	octet[0] = &utc.day;
+	octet[1] = &utc.mon;
+	octet[2] = &utc.year;
+	if (get_octets(argv[9], octet)) {
+		cache->rejected.number++;
+		return -1;
+	}
+
+	/* Make month 0-based */
+	utc.mon--;
+	/* Make year range from 2006 to 2105 */
+	if (utc.year < 6)
+		utc.year += 100;
+
+	if (convert(cache, &utc)) {
+		cache->rejected.range++;
+		return -1;
+	}
+	*utc_secs = cache->last.utc_secs;
+	*dst      = cache->last.dst;
+
+	/* Print the broken-down time back into the corresponding arguments (both were verified to hold exactly 6 digits) */
+	put_time(argv[1], &cache->last.local);
+	digits_put_dec2(&argv[9][0], cache->last.local.day);
+	digits_put_dec2(&argv[9][2], cache->last.local.mon + 1);    /* 1-based */
+	digits_put_dec2(&argv[9][4], cache->last.local.year % 100); /* 2000-based */
+
+	return 0;
+}
+
+
+/*
+ * Rewrites the time of a GPGGA sentence from UTC to local time. GPGGA has no
+ * date, so it's taken from the last conversion in the cache: that of the
+ * GPRMC or GPZDA of the same epoch, or else of the previous one. A time of day
+ * earlier than that of the cache means midnight passed in between, so it's
+ * the day after; the offset may differ then, as the date decides the DST
+ * state. Returns -1 without a cache holding a date, or without a proper time.
+ */
+int lt_gpgga(struct lt_cache_t *cache, int argc, char *argv[])
+{
+	struct rtctime_t  utc;
+	struct rtctime_t  date;
+	rtcsecs_t         day;
+
+	if (!cache || !cache->valid || argc < GPGGA_ARGS_MIN)
+		return -1;
+
+	if (get_time(argv[1], &utc))
+		return -1;
+
+	/* Start of the day of the cache, or of the next one past midnight */
+	day = cache->last.utc_secs - cache->last.utc_secs % SECONDS_PER_DAY;
+	if (utc.hour * SECONDS_PER_HOUR + utc.min * SECONDS_PER_MINUTE + utc.sec <
+	    cache->last.utc_secs - day)
+		day += SECONDS_PER_DAY;
+	rtc_secs2time(day, &date);
+	utc.day  = date.day;
+	utc.mon  = date.mon;
+	utc.year = date.year;
+
+	if (convert(cache, &utc))
+		return -1;
+	put_time(argv[1], &cache->last.local);
+
+	return 0;
+}
+
+
+/*
+ * Rewrites the time and date of a GPZDA sentence from UTC to local time,
+ * leaving the local zone fields alone. Returns -1 if it doesn't hold a
+ * proper time and date.
+ */
+int lt_gpzda(struct lt_cache_t *cache, int argc, char *argv[])
+{
+	struct rtctime_t  utc;
+	unsigned char     century;
+	unsigned char     year;
+
+	if (argc < GPZDA_ARGS_MIN)
+		return -1;
+
+	if (get_time(argv[1], &utc) ||
+	    get_dec2(argv[2], &utc.day) ||
+	    get_dec2(argv[3], &utc.mon) ||
+	    digits_get_dec2(&argv[4][0], &century) ||
+	    get_dec2(&argv[4][2], &year))
+		return -1;
+
+	/* Make month 0-based */
+	utc.mon--;
+	/* Make year range from 2006 to 2105 */
+	if (century < 20 || century > 21)
+		return -1;
+	utc.year = (century - 20) * 100 + year;
+
+	if (convert(cache, &utc))
+		return -1;
+
+	put_time(argv[1], &cache->last.local);
+	digits_put_dec2(argv[2], cache->last.local.day);
+	digits_put_dec2(argv[3], cache->last.local.mon + 1);
+	digits_put_dec2(&argv[4][0], 20 + cache->last.local.year / 100);
+	digits_put_dec2(&argv[4][2], cache->last.local.year % 100);
+
+	return 0;
+}
+
+
+#ifdef LT_PREDICT
+/*
+ * Converts the second after the last conversion ahead of time, for the next
+ * epoch to pick up. Meant for idle time, as it costs as much as converting a
+ * sentence; does nothing without a conversion to go from, or when it's done
+ * already. The sentence only has to match the prediction exactly, so seconds
+ * that don't follow on (a leap second, a receiver skipping a second) simply
+ * convert the usual way.
+ */
+void lt_predict(struct lt_cache_t *cache)
+{
+	struct lt_conv_t  *next = &cache->next;
+
+	if (!cache->valid || cache->predicted)
+		return;
+
+	next->utc_secs = cache->last.utc_secs + 1;
+	rtc_secs2time(next->utc_secs, &next->utc);
+	next->dst = rtc_dst_eu(&next->utc, rtc_weekday(next->utc_secs));
+	rtc_secs2time(next->utc_secs + lt_offset(next->dst), &next->local);
+
+	cache->predicted = 1;
+}
+#endif /* LT_PREDICT */
@@ -0,0 +1,80 @@
+/******************************************************************************/
+/* File    : lt.h                                                             */
+/* Function: Header file of 'lt.c'                                            */
+/* Author  : Robert Delien, agent                                             */
+/* Copyright (C) 2010, Clockwork Engineering                                  */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef LT_H
+#define LT_H
+
+#include "rtc.h"
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define DST_OFFSET_S            (1 * SECONDS_PER_HOUR)
+#define LT_OFFSET_S             (1 * SECONDS_PER_HOUR)
+
+#define TIME_ZONE               (1)
+#define TIME_ZONE_M             (TIME_ZONE * MINUTES_PER_HOUR)
+
+#define LT_PREDICT                      /* Convert the next second ahead of time, see lt_predict() */
+
+#define lt_offset(dst)          (LT_OFFSET_S + ((dst) ? DST_OFFSET_S : 0))  /* Offset of local time to UTC in seconds */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+/* One conversion from UTC to local time */
+struct lt_conv_t {
+	struct rtctime_t  utc;              /* UTC time and date converted */
+	struct rtctime_t  local;            /* Its local time */
+	rtcsecs_t         utc_secs;
+	unsigned char     dst;
+};
+
+/* GPRMC sentences with a good checksum that weren't converted, by reason */
+struct lt_reject_t {
+	unsigned int  args;                 /* Too few arguments to hold the date */
+	unsigned int  status;               /* Status other than 'A', no valid fix */
+	unsigned int  number;               /* Time or date not six digits */
+	unsigned int  range;                /* Time or date out of range of rtc_time2secs() */
+};
+
+/* The last conversion, one per stream, zero-initialized */
+struct lt_cache_t {
+	struct lt_conv_t    last;
+	unsigned char       valid;          /* last holds a conversion */
+	unsigned long       conversions;    /* Conversions done, for sentences not served from the cache */
+	struct lt_reject_t  rejected;
+#ifdef LT_PREDICT
+	struct lt_conv_t    next;           /* Conversion of the second after last, done ahead of time */
+	unsigned char       predicted;      /* next holds a conversion */
+	unsigned long       hits;           /* Sentences served from next instead of converting */
+#endif /* LT_PREDICT */
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+int lt_gprmc(struct lt_cache_t  *cache,
+             int                argc,
+             char               *argv[],
+             rtcsecs_t          *utc_secs,
+             unsigned char      *dst);
+int lt_gpgga(struct lt_cache_t  *cache,
+             int                argc,
+             char               *argv[]);
+int lt_gpzda(struct lt_cache_t  *cache,
+             int                argc,
+             char               *argv[]);
+#ifdef LT_PREDICT
+void lt_predict(struct lt_cache_t  *cache);
+#endif /* LT_PREDICT */
+
+
+#endif /* LT_H */
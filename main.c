@@ -1,7 +1,6 @@
 #include <xc.h>
 
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
 #include "uart1.h"
@@ -9,130 +8,220 @@
 #include "rtc.h"
 #include "cmdline.h"
 #include "nmea.h"
+#include "lt.h"
+#include "event.h"
+#include "sched.h"
+#include "autobaud.h"
+#include "telemetry.h"
+#include "trace.h"
+#include "filter.h"
+#include "digits.h"
 
 
 /******************************************************************************/
 /* Macros                                                                     */
 /******************************************************************************/
-#define DST_OFFSET_S            (1 * SECONDS_PER_HOUR)
-#define LT_OFFSET_S             (1 * SECONDS_PER_HOUR)
-
-#define TIME_ZONE               (1)
-#define TIME_ZONE_M             (TIME_ZONE * MINUTES_PER_HOUR)
-
 //#define TEST_DST
+//#define ISR_STATS                               /* Count interrupt entries and TMR1 ticks spent per interrupt source */
 #define ARRAY_SIZE(x)           (sizeof(x) / sizeof((x)[0]))
 
+#ifdef ISR_STATS
+#define ISR_DISPATCH(src, handler)  do { unsigned int start = TMR1; handler(); isr_account(src, TMR1 - start); } while (0)
+#else
+#define ISR_DISPATCH(src, handler)  handler()
+#endif /* ISR_STATS */
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+#ifdef ISR_STATS
+/* Interrupt sources, in order of dispatch */
+enum isr_src_t {
+	ISR_SRC_RC1 = 0,
+	ISR_SRC_RC2,
+	ISR_SRC_TMR0,
+	ISR_SRC_TMR1,
+	ISR_SRC_TX1,
+	ISR_SRC_TX2,
+	ISR_SRC_COUNT
+};
+
+struct isr_stat_t {
+	unsigned long  entries;    /* Number of times the handler was entered */
+	unsigned long  ticks;      /* Accumulated TMR1 ticks (Fosc/4) spent in the handler */
+	unsigned int   ticks_max;  /* Longest single run of the handler in TMR1 ticks */
+};
+#endif /* ISR_STATS */
+
 
 /******************************************************************************/
 /* Global Data                                                                */
 /******************************************************************************/
+static int cmd_tasks(int argc, char *argv[]);
+static int cmd_outq(int argc, char *argv[]);
+static int cmd_telem(int argc, char *argv[]);
+#ifdef NMEA_AUTOBAUD
+static int cmd_baud(int argc, char *argv[]);
+#endif /* NMEA_AUTOBAUD */
+static const char * const  outq_policy_names[NMEA_OUTQ_POLICIES] = {
+	"drop-new", "drop-old", "latest", "time-first"
+};
+static int cmd_console(int argc, char *argv[]);
+static int cmd_trace(int argc, char *argv[]);
+#ifdef NMEA_CAPTURE
+static int cmd_capture(int argc, char *argv[]);
+#endif /* NMEA_CAPTURE */
+#ifdef LT_PREDICT
+static int cmd_predict(int argc, char *argv[]);
+#endif /* LT_PREDICT */
+static int cmd_filter(int argc, char *argv[]);
+static const char * const  filter_mode_names[FILTER_MODES] = {
+	"off", "drop", "pass"
+};
+static int cmd_drops(int argc, char *argv[]);
+static const char * const  drop_names[NMEA_DROPS] = {
+	"oob", "oversized", "lost", "undersized", "no-separator", "bad-hex", "bad-checksum", "too-many-args", "unsupported"
+};
+static const char * const  console_policy_names[UART2_TX_POLICIES] = {
+	"block", "drop-new", "drop-old"
+};
+#ifdef ISR_STATS
+static int cmd_isr(int argc, char *argv[]);
+static const char * const  isr_src_names[ISR_SRC_COUNT] = {
+	"rc1", "rc2", "tmr0", "tmr1", "tx1", "tx2"
+};
+static struct isr_stat_t   isr_stats[ISR_SRC_COUNT];
+#endif /* ISR_STATS */
+
 const struct command_t  commands[] = {
 	{"?",     cmdline_help},
 	{"help",  cmdline_help},
 	{"echo",  cmdline_echo},
+	{"tasks", cmd_tasks},
+	{"outq",  cmd_outq},
+	{"console", cmd_console},
+	{"trace", cmd_trace},
+#ifdef NMEA_CAPTURE
+	{"capture", cmd_capture},
+#endif /* NMEA_CAPTURE */
+#ifdef LT_PREDICT
+	{"predict", cmd_predict},
+#endif /* LT_PREDICT */
+	{"filter", cmd_filter},
+	{"drops", cmd_drops},
+	{"telem", cmd_telem},
+#ifdef NMEA_AUTOBAUD
+	{"baud",  cmd_baud},
+#endif /* NMEA_AUTOBAUD */
+#ifdef ISR_STATS
+	{"isr",   cmd_isr},
+#endif /* ISR_STATS */
 	{NULL,    NULL}
 };
 
-static void handle_gprmc(int argc, char *argv[]);
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+#ifdef NMEA_GPGGA
+static void handle_gpgga(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+#endif /* NMEA_GPGGA */
+#ifdef NMEA_GPZDA
+static void handle_gpzda(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+#endif /* NMEA_GPZDA */
 const struct nmea_t     nmea[] = {
 	{"GPRMC", handle_gprmc},
+#ifdef NMEA_GPGGA
+	{"GPGGA", handle_gpgga},
+#endif /* NMEA_GPGGA */
+#ifdef NMEA_GPZDA
+	{"GPZDA", handle_gpzda},
+#endif /* NMEA_GPZDA */
 	{NULL,    NULL}
 };
+static struct lt_cache_t  lt_cache;  /* Last conversion, shared by the sentences of an epoch */
+#ifdef LT_PREDICT
+static unsigned char predict_work(void);
+static unsigned char      predicting = 1;  /* Convert the next epoch's time in idle time */
+#endif /* LT_PREDICT */
+
+/* Tasks, in order of priority */
+const struct task_t     tasks[] = {
+	{"nmea",    EVENT_UART1_RX | EVENT_UART1_EOL | NMEA_OUT_EVENT,  nmea_work},
+	{"cmdline", EVENT_UART2_RX | EVENT_UART2_EOL | EVENT_UART1_EOL, cmdline_work},  /* Also after each sentence, for the telemetry posted while handling it */
+#ifdef NMEA_AUTOBAUD
+	{"baud",    EVENT_UART1_RX | EVENT_UART1_ERR,                   autobaud_work},
+#endif /* NMEA_AUTOBAUD */
+#ifdef LT_PREDICT
+	{"predict", EVENT_UART1_EOL,                                    predict_work},
+#endif /* LT_PREDICT */
+	{NULL,      0,                                                  NULL}
+};
 
 
 /******************************************************************************/
 /* Static functions                                                           */
 /******************************************************************************/
-static int get_octets(char *str, unsigned char *octet[])
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[])
 {
-	int  ndx;
+	rtcsecs_t      utc_secs;
+	unsigned char  dst;
+	unsigned int   start = TMR1;
 
-	/* Walk the given string, back to front, two digits at a time */
-	for (ndx = 4; ndx >= 0; ndx -= 2) {
-		char           *endptr;
-		unsigned long  value = strtoul(&str[ndx], &endptr, 10);  /* Convert this part of the string to a numerical value */
+	/* Rewrite the time and date to local time */
+	if (lt_gprmc(&lt_cache, argc, argv, &utc_secs, &dst))
+		return;
+#ifdef NMEA_CAPTURE
+	nmea_capture_out(argc, argv);
+#endif /* NMEA_CAPTURE */
 
-		/* Test for trailing garbage */
-		if (*endptr != '\0') {
-			printf("Error converting %s to a number\n", &str[ndx]);
-			return -1;
-		}
+#ifdef HAS_RTC
+	/* Send the newly received UTC time to the Real Time Clock */
+	rtc_set_time(utc_secs);
+#endif /* HAS_RTC */
 
-		/* Copy the numerical value into the corresponding octet */
-		*octet[ndx >> 1] = (unsigned char)value;
+	nmea_send(argc, argv);
 
-		/* Overwrite the current part of the sting with a 0-terminator, so after we move back to the front, the string stops here */
-		str[ndx] = '\0';
-	}
+	telemetry_epoch(utc_secs,
+	                (int)(lt_offset(dst) / SECONDS_PER_MINUTE),
+	                dst, TMR1 - start);
 
-	return 0;
+	return;
 }
 
 
-static void handle_gprmc(int argc, char *argv[])
+#ifdef LT_PREDICT
+/* Lowest priority, so it only takes the time left after handling the sentences of an epoch */
+static unsigned char predict_work(void)
 {
-	struct rtctime_t  utc;
-	struct rtctime_t  local;
-	rtcsecs_t         utc_secs;
-	rtcsecs_t         local_secs;
-	unsigned char     *octet[3];
-	int               ndx;
-
-	/* Check validity mark */
-	if (strcmp(argv[2], "A"))
-		return;
-
-	/* Get the 3 octets holding the time from the time argument */
-	octet[0] = &utc.hour;
-	octet[1] = &utc.min;
-	octet[2] = &utc.sec;
-	if (get_octets(argv[1], octet))
-		return;
+	if (predicting)
+		lt_predict(&lt_cache);
 
-	/* Get the 3 octets holding the date from the date argument */
-	octet[0] = &utc.day;
-	octet[1] = &utc.mon;
-	octet[2] = &utc.year;
-	if (get_octets(argv[9], octet))
-		return;
+	return 0;
+}
+#endif /* LT_PREDICT */
 
-	/* Make month 0-based */
-	utc.mon--;
-	/* Make year range from 2006 to 2105 */
-	if (utc.year < 6)
-		utc.year += 100;
 
-	/* Convert broken-down UTC time to seconds and complete with weekday */
-	if (rtc_time2secs(&utc, &utc_secs) < 0)
+#ifdef NMEA_GPGGA
+static void handle_gpgga(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	/* Rewrite the time to local time, using the date of the last conversion */
+	if (lt_gpgga(&lt_cache, argc, argv))
 		return;
 
-#ifdef HAS_RTC
-	/* Send the newly received UTC time to the Real Time Clock */
-	rtc_set_time(utc_secs);
-#endif /* HAS_RTC */
-
-	/* Add local time offset and daylight saving time to UTC to get local time */
-	local_secs = utc_secs +
-	             LT_OFFSET_S +
-	             (rtc_dst_eu(&utc, rtc_weekday(utc_secs)) ? DST_OFFSET_S : 0);
-
-	/* Break down local time in seconds */
-	rtc_secs2time(local_secs, &local);
+	nmea_send(argc, argv);
+}
+#endif /* NMEA_GPGGA */
 
-	/* Make month 1-based */
-	local.mon++;
-	/* Make year 2000-based */
-	local.year %= 100;
 
-	/* Print the broken-down time back into the corresponding arguments (snprintf is not supported, modulo 100 should offer enough protection) */
-	sprintf(argv[1], "%02d%02d%02d", local.hour % 100, local.min % 100, local.sec % 100);
-	sprintf(argv[9], "%02d%02d%02d", local.day % 100, local.mon % 100, local.year);
+#ifdef NMEA_GPZDA
+static void handle_gpzda(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	/* Rewrite the time and date to local time */
+	if (lt_gpzda(&lt_cache, argc, argv))
+		return;
 
 	nmea_send(argc, argv);
-
-	return;
 }
+#endif /* NMEA_GPZDA */
 
 
 static void disable_peripherals(void)
@@ -212,11 +301,18 @@ static void init_pins(void)
 
 	/* UART1 */
 	RX1DTPPS = 0x15;  /* Connect RX1 to RC5 input pin */
+#ifndef NMEA_OUT_UART2
 	RC4PPS   = 0x0f;  /* Connect RC4 output to TX1 */
+#endif /* NMEA_OUT_UART2 */
 
 	/* UART2 */
 	RX2DTPPS = 0x11;  /* Connect RX2 to RC1 input pin */
+#ifdef NMEA_OUT_UART2
+	RC4PPS   = 0x11;  /* Connect RC4 output pin to TX2, as NMEA output at its own bit rate */
+	RC0PPS   = 0x00;  /* Disconnect RC0 output pin from TX2 */
+#else
 	RC0PPS   = 0x11;  /* Connect RC0 output pin to TX2 */
+#endif /* NMEA_OUT_UART2 */
 
 	/* TMR0 */
 	RC3PPS   = 0x19;  /* Connect RC3 output pin to TX2 */
@@ -228,6 +324,388 @@ static void init_pins(void)
 }
 
 
+static void init_timebase(void)
+{
+	/* Let timer 1 run freely at Fosc/4 as time base for task and interrupt accounting */
+	T1CONbits.ON   = 0;
+	T1CLKbits.CS   = 1;  /* Clock source Fosc/4 */
+	T1CONbits.CKPS = 0;  /* Pre-scaler 1:1 */
+	T1CONbits.RD16 = 1;  /* Read/write TMR1 in one 16-bit operation */
+	TMR1           = 0;
+	TMR1IF         = 0;
+	TMR1IE         = 1;  /* Count overflows for the trace time stamps */
+	T1CONbits.ON   = 1;
+}
+
+
+/* A line per pass, see cmdline_pass() */
+static int cmd_tasks(int argc, char *argv[])
+{
+	unsigned char             ndx = cmdline_pass();
+	const struct task_stat_t  *stat;
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+	if (argc == 2 && strcmp(argv[1], "reset"))
+		return ERR_SYNTAX;
+
+	if (!ndx) {
+		printf("task      runs       ticks      max\n");
+		return ERR_MORE;
+	}
+	ndx--;
+	stat = sched_stat(ndx);
+	printf("%-8s  %9lu  %9lu  %5u\n", tasks[ndx].name, stat->runs, stat->ticks, stat->ticks_max);
+	if (tasks[ndx + 1].function)
+		return ERR_MORE;
+	if (argc == 2)
+		sched_reset_stats();
+
+	return ERR_OK;
+}
+
+
+/* A line per pass */
+static int cmd_outq(int argc, char *argv[])
+{
+	struct nmea_outq_stat_t  stat;
+	unsigned char            ndx;
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+
+	nmea_outq_stat(&stat);
+	switch (cmdline_pass()) {
+	case 0:
+		if (argc == 2) {
+			for (ndx = 0; ndx < NMEA_OUTQ_POLICIES; ndx++)
+				if (!strcmp(argv[1], outq_policy_names[ndx]))
+					break;
+			if (ndx >= NMEA_OUTQ_POLICIES)
+				return ERR_PARAM;
+			nmea_outq_policy((enum nmea_outq_policy_t)ndx);
+		}
+		printf("Policy: %s\n", outq_policy_names[nmea_outq_get_policy()]);
+		return ERR_MORE;
+	case 1:
+		printf("Used: %u/%u (peak %u)\n", stat.used, NMEA_OUTQ_LEN, stat.peak);
+		return ERR_MORE;
+	case 2:
+		printf("Queued: %lu\n", stat.queued);
+		return ERR_MORE;
+	}
+	printf("Dropped: %lu\n", stat.dropped);
+
+	return ERR_OK;
+}
+
+
+/* A line per pass */
+static int cmd_console(int argc, char *argv[])
+{
+	unsigned char  ndx;
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+
+	if (cmdline_pass()) {
+		printf("Lost: %lu\n", uart2_tx_lost());
+		return ERR_OK;
+	}
+
+	if (argc == 2) {
+		for (ndx = 0; ndx < UART2_TX_POLICIES; ndx++)
+			if (!strcmp(argv[1], console_policy_names[ndx]))
+				break;
+		if (ndx >= UART2_TX_POLICIES)
+			return ERR_PARAM;
+		uart2_tx_policy((enum uart2_tx_policy_t)ndx);
+	}
+	printf("Policy: %s\n", console_policy_names[uart2_tx_get_policy()]);
+
+	return ERR_MORE;
+}
+
+
+/* Dump the trace ring in hex, an entry per pass, for host/tracedec to decode (and order by sequence number) */
+static int cmd_trace(int argc, char *argv[])
+{
+	const struct trace_entry_t  *entry;
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+	if (argc == 2 && strcmp(argv[1], "clear"))
+		return ERR_SYNTAX;
+
+	if ((entry = trace_entry(cmdline_pass())) != NULL) {
+		printf(TRACE_TAG " %.2x %.2x %.2x %.4x%.4x\n", entry->seq, entry->id, entry->arg, entry->wraps, entry->tick);
+		return ERR_MORE;
+	}
+	if (argc == 2)
+		trace_clear();
+
+	return ERR_OK;
+}
+
+
+#ifdef NMEA_CAPTURE
+/* Dump the latest sentences received, and their rewrites, with TMR1 time stamps, a segment of a line per pass */
+static int cmd_capture(int argc, char *argv[])
+{
+	if (argc > 1)
+		return ERR_SYNTAX;
+
+	if (nmea_capture_dump(cmdline_pass()))
+		return ERR_MORE;
+	printf("Capture cost: max %u ticks\n", nmea_capture_ticks_max());
+
+	return ERR_OK;
+}
+#endif /* NMEA_CAPTURE */
+
+
+#ifdef LT_PREDICT
+/* Switch conversion ahead of time on or off, to compare the latency in the telemetry. A line per pass */
+static int cmd_predict(int argc, char *argv[])
+{
+	if (argc > 2)
+		return ERR_SYNTAX;
+
+	if (cmdline_pass()) {
+		printf("Hits: %lu of %lu\n", lt_cache.hits, lt_cache.hits + lt_cache.conversions);
+		return ERR_OK;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "on")) {
+			predicting = 1;
+		} else if (!strcmp(argv[1], "off")) {
+			predicting = 0;
+			lt_cache.predicted = 0;
+		} else
+			return ERR_PARAM;
+	}
+
+	printf("Prediction %s\n", predicting ? "on" : "off");
+
+	return ERR_MORE;
+}
+#endif /* LT_PREDICT */
+
+
+/* Print a filter mask in hex, followed by the names of the bits set */
+static void print_mask(const char *label, unsigned char mask, const char *(*name)(unsigned char bit))
+{
+	unsigned char  bit;
+
+	printf("%s: %.2x", label, mask);
+	for (bit = 0; name(bit); bit++)
+		if (mask & (1 << bit))
+			printf(" %s", name(bit));
+	printf("\n");
+}
+
+
+/* Select the sentences handled by talker and type, with masks of two hex digits. A line per pass */
+static int cmd_filter(int argc, char *argv[])
+{
+	struct nmea_stat_t  stat;
+	unsigned char       talkers = filter_talkers();
+	unsigned char       types = filter_types();
+	unsigned char       ndx;
+
+	if (argc != 1 && argc != 2 && argc != 4)
+		return ERR_SYNTAX;
+
+	nmea_stat(&stat);
+	switch (cmdline_pass()) {
+	case 0:
+		if (argc >= 2) {
+			for (ndx = 0; ndx < FILTER_MODES; ndx++)
+				if (!strcmp(argv[1], filter_mode_names[ndx]))
+					break;
+			if (ndx >= FILTER_MODES)
+				return ERR_PARAM;
+			if (argc == 4 &&
+			    (strlen(argv[2]) != 2 || digits_get_hex2(argv[2], &talkers) ||
+			     strlen(argv[3]) != 2 || digits_get_hex2(argv[3], &types)))
+				return ERR_PARAM;
+			filter_set((enum filter_mode_t)ndx, talkers, types);
+		}
+		printf("Mode: %s\n", filter_mode_names[filter_mode()]);
+		return ERR_MORE;
+	case 1:
+		print_mask("Talkers", filter_talkers(), filter_talker_name);
+		return ERR_MORE;
+	case 2:
+		print_mask("Types", filter_types(), filter_type_name);
+		return ERR_MORE;
+	case 3:
+		printf("Filtered: %lu\n", stat.filtered);
+		return ERR_MORE;
+#if UART1_RX_FRAMES
+	case 4:
+		/* The rx interrupt drops what it can decide on before the parser sees it, the parser the rest */
+		printf("Filtered in rx interrupt: %u\n", uart1_rx_filtered());
+		return ERR_MORE;
+#endif /* UART1_RX_FRAMES */
+	}
+	printf("Passed: %lu\n", stat.passed);
+
+	return ERR_OK;
+}
+
+
+/* Why sentences were dropped, to tell a bad link from a bad fix. A line per pass */
+static int cmd_drops(int argc, char *argv[])
+{
+	struct nmea_stat_t  stat;
+	unsigned char       ndx = cmdline_pass();
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+	if (argc == 2 && strcmp(argv[1], "reset"))
+		return ERR_SYNTAX;
+
+	nmea_stat(&stat);
+	switch (ndx) {
+	case 0:
+		printf("Framed: %lu\nValid: %lu\n", stat.framed, stat.valid);
+		return ERR_MORE;
+	case 1:
+		printf("reason         count\n");
+		return ERR_MORE;
+	default:
+		ndx -= 2;
+		if (ndx < NMEA_DROPS) {
+			printf("%-13s  %5u\n", drop_names[ndx], stat.drops[ndx]);
+			return ERR_MORE;
+		}
+	}
+
+	/* GPRMC with a good checksum, but not converted */
+	switch (ndx - NMEA_DROPS) {
+	case 0:
+		printf("%-13s  %5u\n", "rmc-args", lt_cache.rejected.args);
+		return ERR_MORE;
+	case 1:
+		printf("%-13s  %5u\n", "rmc-status", lt_cache.rejected.status);
+		return ERR_MORE;
+	case 2:
+		printf("%-13s  %5u\n", "rmc-number", lt_cache.rejected.number);
+		return ERR_MORE;
+	}
+	printf("%-13s  %5u\n", "rmc-range", lt_cache.rejected.range);
+	if (argc == 2) {
+		nmea_drops_reset();
+		memset(&lt_cache.rejected, 0, sizeof(lt_cache.rejected));
+	}
+
+	return ERR_OK;
+}
+
+
+/* A line per pass */
+static int cmd_telem(int argc, char *argv[])
+{
+	unsigned int  count = 0;
+	const char    *ch;
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+
+	if (cmdline_pass()) {
+		printf("Dropped: %u\n", telemetry_dropped());
+		return ERR_OK;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "on")) {
+			count = TELEMETRY_INTERVAL;
+		} else if (strcmp(argv[1], "off")) {
+			/* Number of epochs between records */
+			for (ch = argv[1]; *ch; ch++) {
+				if (*ch < '0' || *ch > '9' || (count = count * 10 + (*ch - '0')) > 0xff)
+					return ERR_PARAM;
+			}
+		}
+		telemetry_interval((unsigned char)count);
+	}
+
+	if (telemetry_get_interval())
+		printf("Telemetry every %u epochs\n", telemetry_get_interval());
+	else
+		printf("Telemetry off\n");
+
+	return ERR_MORE;
+}
+
+
+#ifdef NMEA_AUTOBAUD
+/* A line per pass */
+static int cmd_baud(int argc, char *argv[])
+{
+	if (argc > 1)
+		return ERR_SYNTAX;
+
+	switch (cmdline_pass()) {
+	case 0:
+		printf("NMEA in: %lu bit/s, %s\n", autobaud_bitrate(), autobaud_locked() ? "locked" : "searching");
+		return ERR_MORE;
+	case 1:
+		printf("Receive errors: %u\n", uart1_rx_errors());
+		return ERR_MORE;
+	}
+	printf("Characters dropped: %u\n", uart1_rx_dropped());
+
+	return ERR_OK;
+}
+#endif /* NMEA_AUTOBAUD */
+
+
+#ifdef ISR_STATS
+static void isr_account(enum isr_src_t src, unsigned int ticks)
+{
+	struct isr_stat_t  *stat = &isr_stats[src];
+
+	stat->entries++;
+	stat->ticks += ticks;
+	if (ticks > stat->ticks_max)
+		stat->ticks_max = ticks;
+}
+
+
+/* A line per pass, see cmdline_pass() */
+static int cmd_isr(int argc, char *argv[])
+{
+	struct isr_stat_t  stat;
+	unsigned char      ndx = cmdline_pass();
+
+	if (argc > 2)
+		return ERR_SYNTAX;
+	if (argc == 2 && strcmp(argv[1], "reset"))
+		return ERR_SYNTAX;
+
+	if (!ndx) {
+		printf("src   entries    ticks      max\n");
+		return ERR_MORE;
+	}
+	ndx--;
+
+	/* Take a consistent snapshot (and optionally reset) of a source with interrupts disabled */
+	GIE = 0;
+	stat = isr_stats[ndx];
+	if (argc == 2)
+		memset(&isr_stats[ndx], 0, sizeof(isr_stats[ndx]));
+	GIE = 1;
+
+	printf("%-4s  %9lu  %9lu  %5u\n", isr_src_names[ndx], stat.entries, stat.ticks, stat.ticks_max);
+
+	return (ndx + 1 < ISR_SRC_COUNT) ? ERR_MORE : ERR_OK;
+}
+#endif /* ISR_STATS */
+
+
 static void init_interrupt(void)
 {
 	/* Enable peripheral interrupts */
@@ -243,27 +721,47 @@ static void init_interrupt(void)
 /******************************************************************************/
 void __interrupt() isr(void)
 {
+	/*
+	 * Only dispatch sources that are both flagged and enabled: TXxIF is set
+	 * whenever the transmit register is empty, regardless of TXxIE. Sources
+	 * are tested in order of urgency: receivers first, as they lose data
+	 * when not serviced within a character time, then the timers, then the
+	 * transmitters.
+	 */
+
+	/* (E)USART 1 receive interrupt (NMEA input) */
+	if (RC1IE && RC1IF)
+		ISR_DISPATCH(ISR_SRC_RC1, uart1_rx_isr);
+
+	/* (E)USART 2 receive interrupt (console input) */
+	if (RC2IE && RC2IF)
+		ISR_DISPATCH(ISR_SRC_RC2, uart2_rx_isr);
+
 #ifdef HAS_RTC
 	/* Timer 0 interrupt */
-	if (TMR0IF) {
+	if (TMR0IE && TMR0IF) {
 		/* Reset interrupt */
 		TMR0IF = 0;
 		/* Handle interrupt */
-		rtc_isr();
+		ISR_DISPATCH(ISR_SRC_TMR0, rtc_isr);
 	}
 #endif /* HAS_RTC */
 
-	/* (E)USART 1 interrupts */
-	if (RC1IF)
-		uart1_rx_isr();
-	if (TX1IF)
-		uart1_tx_isr();
-
-	/* (E)USART 2 interrupts */
-	if (RC2IF)
-		uart2_rx_isr();
-	if (TX2IF)
-		uart2_tx_isr();
+	/* Timer 1 interrupt */
+	if (TMR1IE && TMR1IF) {
+		/* Reset interrupt */
+		TMR1IF = 0;
+		/* Handle interrupt */
+		ISR_DISPATCH(ISR_SRC_TMR1, trace_isr);
+	}
+
+	/* (E)USART 1 transmit interrupt */
+	if (TX1IE && TX1IF)
+		ISR_DISPATCH(ISR_SRC_TX1, uart1_tx_isr);
+
+	/* (E)USART 2 transmit interrupt */
+	if (TX2IE && TX2IF)
+		ISR_DISPATCH(ISR_SRC_TX2, uart2_tx_isr);
 }
 
 
@@ -271,11 +769,31 @@ void main(void)
 {
 	disable_peripherals();
 	init_clocks();
+#ifdef HAS_RTC
+	/* Start with the oscillator tuning of the previous run */
+	rtc_restore();
+#endif /* HAS_RTC */
 	init_pins();
 
+#ifdef NMEA_OUT_UART2
+	/* UART2 transmits the NMEA output, so there's no room for console output */
+	uart2_console(0);
+	uart2_init(NMEA_OUT_BITRATE, 0);
+#else
 	/* Initialize the serial port for stdio */
 	uart2_init(115200, 0);
-	uart1_init(4800, 0);
+#endif /* NMEA_OUT_UART2 */
+	uart1_init(NMEA_IN_BITRATE, 0);
+#ifdef NMEA_AUTOBAUD
+	autobaud_init(NMEA_IN_BITRATE);
+#endif /* NMEA_AUTOBAUD */
+
+	init_timebase();
+	TRACE(TRACE_BOOT, 0);
+	sched_init();
+
+	/* Initialize interrupts, before any output as the console transmits from the tx interrupt */
+	init_interrupt();
 
 	printf("\n*** NMEA local time converter ***\n");
 	if (!nPOR)
@@ -292,18 +810,17 @@ void main(void)
 	nBOR = 1;
 
 #ifdef TEST_DST
+	/* Far more output than the console queue holds, so wait for room */
+	uart2_tx_wait(1);
 	rtc_dst_eu_test();
+	uart2_tx_wait(0);
 #endif /* TEST_DST */
 
 	cmdline_init();
 
-	/* Initialize interrupts */
-	init_interrupt();
-
 	/* Execute the run loop */
 	for(;;) {
-		cmdline_work();
-		nmea_work();
+		sched_run();
 		CLRWDT();
 	}
 }
@@ -2,261 +2,505 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <stdlib.h>
 
 #include "uart1.h"
+#include "uart2.h"
+#include "nmeactx.h"
+#include "filter.h"
+#include "trace.h"
 
 #include "nmea.h"
 
+#if UART1_RX_LOST != NMEA_LOST
+#error The parser must recognize the characters lost by UART1
+#endif
+#if UART1_RX_FRAMES && UART1_FRAME_LEN - 1 < NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN
+#error UART1 frames must hold the longest sentence the parser accepts
+#endif
+#if defined(NMEA_CAPTURE) && UART1_RX_FRAMES > 1
+#error The capture takes the RAM of the second UART1 frame, build it with UART1_RX_FRAMES 1
+#endif
+
 
 /******************************************************************************/
 /* Macros                                                                     */
 /******************************************************************************/
 //#define                    DEBUG
 
-#define NMEA_HEADER                  '$'
-#define NMEA_TRAILER1                '\r'
-#define NMEA_TRAILER2                '\n'
-#define NMEA_SEPARATOR               ','
-#define NMEA_CHECKSUM_SEPARATOR      '*'
+#define NMEA_BURST_LEN               8   /* Number of bytes fetched from the UART at once */
+#define NMEA_CAPTURE_FIELD_LEN       6   /* Length of the GPRMC time and date fields, as verified by lt_gprmc() */
+#define NMEA_CAPTURE_TIME            1   /* Index of the GPRMC time field */
+#define NMEA_CAPTURE_DATE            9   /* Index of the GPRMC date field */
+#define NMEA_CAPTURE_SEGMENT_LEN     32  /* Characters of a captured sentence printed per call of nmea_capture_dump() */
+#define NMEA_WORK_BURSTS             2   /* Number of bursts processed per call of nmea_work() */
+#define NMEA_URGENT                  "RMC"  /* Sentence type handled ahead of the others received, of any talker */
+#define NMEA_TIME_TYPES              "RMC", "GGA", "ZDA"  /* Sentence types carrying the time, kept by NMEA_OUTQ_TIME_FIRST */
+
+#ifdef NMEA_OUT_UART2
+#define NMEA_OUT_SEND(data, len)     uart2_send(data, len)
+#define NMEA_OUT_SENDING()           uart2_sending()
+#else
+#define NMEA_OUT_SEND(data, len)     uart1_send(data, len)
+#define NMEA_OUT_SENDING()           uart1_sending()
+#endif /* NMEA_OUT_UART2 */
 
-#define NMEA_LEN_MAX                 82
-#define NMEA_HEADER_LEN              1
-#define NMEA_CHECKSUM_SEPARATOR_LEN  1
-#define NMEA_CHECKSUM_LEN            2
-#define NMEA_TRAILER_LEN             2
-#define NMEA_DATA_LEN_MAX            (NMEA_LEN_MAX - NMEA_HEADER_LEN - NMEA_CHECKSUM_SEPARATOR_LEN - NMEA_CHECKSUM_LEN - NMEA_TRAILER_LEN)
 
-#define NMEA_ARGS_MAX                12
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct outq_t {
+	char                     sentence[NMEA_OUTQ_LEN][NMEA_LEN_MAX + 1];
+	unsigned char            len[NMEA_OUTQ_LEN];
+	unsigned char            head;      /* Index of the oldest sentence */
+	unsigned char            used;      /* Number of sentences queued */
+	unsigned char            sending;   /* The oldest sentence was handed to the tx interrupt */
+	enum nmea_outq_policy_t  policy;
+	struct nmea_outq_stat_t  stat;
+};
+
+#ifdef NMEA_CAPTURE
+/* A sentence as received and, for a rewritten GPRMC, the fields that changed */
+struct capture_t {
+	char                     in[NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN];
+	unsigned char            in_len;
+	unsigned int             in_tick;   /* TMR1 when the trailer was received */
+	char                     time[NMEA_CAPTURE_FIELD_LEN];
+	char                     date[NMEA_CAPTURE_FIELD_LEN];
+	unsigned int             out_tick;  /* TMR1 when the rewrite was captured */
+	unsigned char            out;       /* The sentence was rewritten */
+};
+#endif /* NMEA_CAPTURE */
 
 
 /******************************************************************************/
 /* Global Data                                                                */
 /******************************************************************************/
 extern const struct nmea_t  nmea[];
+static void pass_sentence(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len);
+#ifdef NMEA_CAPTURE
+static void capture_in(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len);
+static struct nmea_ctx_t    ctx = { nmea, NULL, capture_in, filter_address, pass_sentence };  /* The one NMEA stream of the firmware */
+static struct capture_t     capture[NMEA_CAPTURE_LEN];
+static unsigned char        capture_next;       /* Index of the entry the next sentence goes in */
+static unsigned char        capture_used;       /* Number of entries holding a sentence */
+static unsigned int         capture_ticks_max;  /* Longest time spent capturing a sentence or rewrite */
+static unsigned char        dump_nth;           /* Entry nmea_capture_dump() is printing */
+static unsigned char        dump_out;           /* It's printing the rewrite of the entry */
+static unsigned char        dump_from;          /* Index in the sentence to continue at, 0 to start a line */
+#else
+static struct nmea_ctx_t    ctx = { nmea, NULL, NULL, filter_address, pass_sentence };  /* The one NMEA stream of the firmware */
+#endif /* NMEA_CAPTURE */
+static struct outq_t        outq;
 
 
 /******************************************************************************/
 /* Static functions                                                           */
 /******************************************************************************/
-static unsigned char calc_checksum(char *buf, unsigned char len)
+/* Index of the n-th queued sentence */
+static unsigned char outq_index(unsigned char nth)
 {
-	unsigned char  ndx;
-	unsigned char  calcsum = 0;
-
-	for (ndx = 0; ndx < len; ndx++)
-		calcsum ^= buf[ndx];
+	unsigned char  ndx = outq.head + nth;
 
-	return calcsum;
+	return (ndx >= NMEA_OUTQ_LEN) ? ndx - NMEA_OUTQ_LEN : ndx;
 }
 
 
-static int keyword2index(char *keyword)
+/* Remove the n-th queued sentence, which must not be in transmission */
+static void outq_remove(unsigned char nth)
 {
-	int  ndx = 0;
+	for (; nth + 1 < outq.used; nth++) {
+		unsigned char  to   = outq_index(nth);
+		unsigned char  from = outq_index(nth + 1);
 
-	while (nmea[ndx].keyword) {
-		if (!strcmp (keyword, nmea[ndx].keyword))
-			return ndx;
-		ndx++;
+		memcpy(outq.sentence[to], outq.sentence[from], outq.len[from]);
+		outq.len[to] = outq.len[from];
 	}
-
-	return -1;
+	outq.used--;
+	outq.stat.dropped++;
+	TRACE(TRACE_NMEA_OUTQ_DROP, outq.used);
 }
 
 
-static void proc_nmea_sentence(char *sentence, unsigned char len)
+/* Test if an address field is that of a sentence carrying the time, of any talker */
+static unsigned char outq_time(const char *address)
 {
-	int            ndx;
-	char           *endptr;
-	unsigned long  checksum;
-	unsigned char  calcsum;
-	int            argc = 0;
-	char           *argv[NMEA_ARGS_MAX];
-
-	if (len < NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
-#ifdef DEBUG
-		printf("NMEA: Dropping under-sized sentence '%s'\n", sentence);
-#endif /* DEBUG */
-		return;
-	}
+	static const char * const  types[] = { NMEA_TIME_TYPES };
+	unsigned char              ndx;
 
-	if (sentence[len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN] != NMEA_CHECKSUM_SEPARATOR) {
-#ifdef DEBUG
-		printf("NMEA: Dropping sentence without checksum separator '%s'\n", sentence);
-#endif /* DEBUG */
-		return;
-	}
+	for (ndx = 0; ndx < sizeof(types) / sizeof(types[0]); ndx++)
+		if (!memcmp(&address[NMEA_TALKER_LEN], types[ndx], NMEA_ADDRESS_LEN - NMEA_TALKER_LEN))
+			return 1;
 
-	checksum = strtoul(&sentence[len - NMEA_CHECKSUM_LEN], &endptr, 16);
-	if (*endptr != '\0') {
-#ifdef DEBUG
-		printf("NMEA: Dropping sentence with non-numerical checksum '%s'\n", sentence);
-#endif /* DEBUG */
-		return;
-	}
+	return 0;
+}
 
-	calcsum = calc_checksum(sentence, len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN);
-	if (calcsum != checksum) {
-#ifdef DEBUG
-		printf("NMEA: Dropping sentence with bad checksum 0x%.2x '%s'\n", calcsum, sentence);
-#endif /* DEBUG */
-		return;
-	}
-	sentence[len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN] = '\0';
-	len -= NMEA_CHECKSUM_LEN + NMEA_CHECKSUM_SEPARATOR_LEN;
-
-	/* Build argument list */
-	while (*sentence != '\0') {
-		/* Replace leading separators with 0-terminations and add an empty argument for each one */
-		while (*sentence == NMEA_SEPARATOR) {
-			if (argc >= NMEA_ARGS_MAX) {
-#ifdef DEBUG
-				printf("NMEA: Dropping sentence with too many arguments\n");
-#endif /* DEBUG */
-				return;
-			}
-			*sentence = '\0';
-			argv[argc++] = sentence;
-			sentence++;
-		}
 
-		/* Store the beginning of this argument */
-		if (*sentence != '\0') {
-			if (argc >= NMEA_ARGS_MAX) {
-#ifdef DEBUG
-				printf("NMEA: Dropping sentence with too many arguments\n");
-#endif /* DEBUG */
-				return;
+/*
+ * Make room for a new sentence with the given address field as the policy
+ * says. Returns the slot to write it in, room for NMEA_LEN_MAX characters and
+ * a 0-termination, queued by outq_commit(), or NULL if it's dropped.
+ */
+static char *outq_slot(const char *address)
+{
+	unsigned char  first = outq.sending;  /* The oldest sentence can't be touched once its transmission started */
+	unsigned char  nth;
+
+	/* Replace a queued sentence with the same address field */
+	if (outq.policy == NMEA_OUTQ_LATEST) {
+		for (nth = first; nth < outq.used; nth++) {
+			if (!memcmp(&outq.sentence[outq_index(nth)][NMEA_HEADER_LEN], address, NMEA_ADDRESS_LEN)) {
+				outq_remove(nth);
+				break;
 			}
-			argv[argc++] = sentence;
 		}
+	}
 
-		/* Skip characters until past argument (indicated by a separator or a 0-termination) */
-		while (*sentence != '\0' &&
-		       *sentence != NMEA_SEPARATOR) {
-			sentence++;
+	/* Make room if required and allowed */
+	if (outq.used >= NMEA_OUTQ_LEN) {
+		nth = first;
+		if (outq.policy == NMEA_OUTQ_TIME_FIRST) {
+			/* Rather than one carrying the time, evict the oldest other sentence, or else drop the new one if it's another */
+			while (nth < outq.used && outq_time(&outq.sentence[outq_index(nth)][NMEA_HEADER_LEN]))
+				nth++;
+			if (nth >= outq.used)
+				nth = outq_time(address) ? first : outq.used;
 		}
-
-		/* If the argument was terminated by a separator, replace is with a 0-termination */
-		if (*sentence == NMEA_SEPARATOR) {
-			*sentence = '\0';
-			sentence++;
+		if (outq.policy == NMEA_OUTQ_DROP_NEW || nth >= outq.used) {
+			outq.stat.dropped++;
+			TRACE(TRACE_NMEA_OUTQ_DROP, outq.used);
+			return NULL;
 		}
+		outq_remove(nth);
 	}
 
-	if ((ndx = keyword2index(argv[0])) < 0) {
+	return outq.sentence[outq_index(outq.used)];
+}
+
+
+/* Queue the sentence of len characters written to the slot of outq_slot() */
+static void outq_commit(unsigned char len)
+{
+	unsigned char  ndx = outq_index(outq.used);
+
 #ifdef DEBUG
-		printf("NMEA: unsupported sentence '%s'\n", argv[0]);
+	printf("Sending '%s'\n", outq.sentence[ndx]);
 #endif /* DEBUG */
-		return;
-	}
 
-	nmea[ndx].function(argc, argv);
+	outq.len[ndx] = len;
+	outq.used++;
+	outq.stat.queued++;
+	if (outq.used > outq.stat.peak)
+		outq.stat.peak = outq.used;
 }
 
 
-static void proc_nmea_char(char byte)
+#ifdef NMEA_CAPTURE
+static void capture_account(unsigned int start)
 {
-	static char           sentence[NMEA_DATA_LEN_MAX +
-	                               NMEA_CHECKSUM_SEPARATOR_LEN +
-	                               NMEA_CHECKSUM_LEN + 1];
-	static unsigned char  len;
-	static unsigned char  receiving = 0;
-
-	/* Test if we need to start receiving */
-	if (!receiving) {
-		switch (byte) {
-		default:
-		case NMEA_TRAILER1:
-#ifdef DEBUG
-			printf("NMEA: Discarding OOB byte 0x%.2x\n", byte);
-#endif /* DEBUG */
-		case NMEA_TRAILER2:
-			return;
-
-		case NMEA_HEADER:
-			/* Start receiving and reset the received length */
-			receiving = 1;
-			len = 0;
-			return;
+	unsigned int  ticks = TMR1 - start;
+
+	if (ticks > capture_ticks_max)
+		capture_ticks_max = ticks;
+}
+
+
+/* Keep a framed sentence before the parser splits it up in place, takes one bounded copy */
+static void capture_in(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len)
+{
+	unsigned int      start = TMR1;
+	struct capture_t  *entry = &capture[capture_next];
+
+	memcpy(entry->in, sentence, len);
+	entry->in_len  = len;
+	entry->in_tick = start;
+	entry->out     = 0;
+	if (++capture_next >= NMEA_CAPTURE_LEN)
+		capture_next = 0;
+	if (capture_used < NMEA_CAPTURE_LEN)
+		capture_used++;
+	capture_account(start);
+}
+
+
+/*
+ * Print up to NMEA_CAPTURE_SEGMENT_LEN characters of a captured sentence from
+ * index from on, with the captured fields in place of the received ones (of
+ * the same length) if rewritten. Returns the index to continue at, or 0 at
+ * the end of the sentence.
+ */
+static unsigned char capture_print(const struct capture_t *entry, unsigned char rewritten, unsigned char from)
+{
+	unsigned char  field = 0;
+	unsigned char  pos = 0;  /* Index in the field */
+	unsigned char  checksum = 0;
+	unsigned char  ndx;
+
+	for (ndx = 0; ndx < entry->in_len; ndx++) {
+		char  ch = entry->in[ndx];
+
+		if (ndx >= from + NMEA_CAPTURE_SEGMENT_LEN)
+			return ndx;
+		if (ch == ',') {
+			field++;
+			pos = 0;
+		} else if (rewritten && ch == '*') {
+			/* Replace the checksum */
+			if (ndx >= from)
+				printf("*%.2X", checksum);
+			return 0;
+		} else {
+			if (rewritten && pos < NMEA_CAPTURE_FIELD_LEN && (field == NMEA_CAPTURE_TIME || field == NMEA_CAPTURE_DATE))
+				ch = (field == NMEA_CAPTURE_TIME) ? entry->time[pos] : entry->date[pos];
+			pos++;
 		}
+		checksum ^= ch;
+		if (ndx >= from)
+			putchar(ch == NMEA_LOST ? '?' : ch);
 	}
 
-	/* Test if we need to end receiving */
-	if (byte == NMEA_TRAILER2 ||
-	    byte == NMEA_TRAILER1) {
-		receiving = 0;
-		sentence[len] = '\0';
-		proc_nmea_sentence(sentence, len);
+	return 0;
+}
+#endif /* NMEA_CAPTURE */
+
+
+#if UART1_RX_FRAMES
+/* The received sentence to handle next: the oldest urgent one, or else the oldest */
+static char *frame_next(unsigned char *len)
+{
+	char           *sentence;
+	unsigned char  nth;
+
+	for (nth = 0; (sentence = uart1_frame(nth, len)) != NULL; nth++)
+		if (*len >= NMEA_ADDRESS_LEN &&
+		    !memcmp(&sentence[NMEA_TALKER_LEN], NMEA_URGENT, NMEA_ADDRESS_LEN - NMEA_TALKER_LEN))
+			return sentence;
+
+	return uart1_frame(0, len);
+}
+#endif /* UART1_RX_FRAMES */
+
+
+/*
+ * Hand the oldest queued sentence to the tx interrupt once the one before it
+ * is out. Doesn't wait: the interrupt posts NMEA_OUT_EVENT when it's done.
+ */
+static void outq_work(void)
+{
+	if (NMEA_OUT_SENDING())
 		return;
+	if (outq.sending) {
+		outq.sending = 0;
+		outq.head = outq_index(1);
+		outq.used--;
 	}
+	if (outq.used)
+		outq.sending = NMEA_OUT_SEND(outq.sentence[outq.head], outq.len[outq.head]);
+}
 
-	/* Copy the received byte into the current received sentence */
-	sentence[len] = byte;
 
-	if (++len >= NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
-		receiving = 0;
-		sentence[len] = '\0';
-#ifdef DEBUG
-		printf("NMEA: Discarding over-sized sentence '%s'\n", sentence);
-#endif /* DEBUG */
+/* Send a sentence the filter passes on as received, leaving checking it to the sink */
+static void pass_sentence(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len)
+{
+	char  *out;
+
+	(void)ctx;
+	if ((out = outq_slot(sentence)) != NULL) {
+		out[0] = NMEA_HEADER;
+		memcpy(&out[NMEA_HEADER_LEN], sentence, len);
+		memcpy(&out[NMEA_HEADER_LEN + len], "\r\n", NMEA_TRAILER_LEN + 1);
+		outq_commit(NMEA_HEADER_LEN + len + NMEA_TRAILER_LEN);
 	}
+	outq_work();
 }
 
 
 /******************************************************************************/
 /* Functions                                                                  */
 /******************************************************************************/
-void nmea_work(void)
+#if UART1_RX_FRAMES
+unsigned char nmea_work(void)
 {
-	char  byte;
+	char           *sentence;
+	unsigned char  len;
+
+	/* Handle one sentence framed by the rx interrupt per call */
+	if ((sentence = frame_next(&len)) == NULL) {
+		/* Input done, the output is up to the tx interrupt */
+		outq_work();
+		return 0;
+	}
+	nmea_ctx_frame(&ctx, sentence, len);
+	uart1_frame_release(sentence);
+	outq_work();
+
+	/* There may be more */
+	return 1;
+}
+#else
+unsigned char nmea_work(void)
+{
+	char           burst[NMEA_BURST_LEN];
+	unsigned char  bursts;
+	unsigned char  len;
+	unsigned char  ndx;
+
+	/* Fetch what was received in bursts, but no more than the budget per call */
+	for (bursts = 0; bursts < NMEA_WORK_BURSTS; bursts++) {
+		if ((len = uart1_read(burst, sizeof(burst))) == 0) {
+			/* Input done, the output is up to the tx interrupt */
+			outq_work();
+			return 0;
+		}
+		for (ndx = 0; ndx < len; ndx++)
+			nmea_ctx_char(&ctx, burst[ndx]);
+		outq_work();
+	}
 
-	while ((byte = uart1_getch()) != (char)EOF)
-		proc_nmea_char(byte);
+	/* Budget exhausted, there may be more */
+	return 1;
 }
+#endif /* UART1_RX_FRAMES */
 
 
+/*
+ * Build a sentence from the arguments straight into the output queue, if the
+ * policy makes room for it.
+ */
 void nmea_send(int argc, char *argv[])
 {
-	static char    sentence[NMEA_LEN_MAX + 1] = { NMEA_HEADER };
-	unsigned char  sentence_ndx = NMEA_HEADER_LEN;
-	unsigned char  send_ndx;
-	int            arg_ndx = 0;
+	char           *out;
+	unsigned char  len;
 
-	for (;;) {
-		size_t  len = strlen(argv[arg_ndx]);
+	if ((out = outq_slot(argv[0])) != NULL &&
+	    nmea_ctx_build(out, argc, argv, &len) != NULL)
+		outq_commit(len);
+	outq_work();
+}
+
+
+/*
+ * Where to write the data of a sentence with the given address field for
+ * nmea_send_data(), room for NMEA_DATA_LEN_MAX characters, in the output
+ * queue. Returns NULL if the policy drops it.
+ */
+char *nmea_data(const char *address)
+{
+	char  *out;
 
-		/* Test if there's space for the argument */
-		if (sentence_ndx + len > NMEA_LEN_MAX - NMEA_TRAILER_LEN - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN)
-			return;
+	if ((out = outq_slot(address)) == NULL)
+		return NULL;
+
+	return nmea_ctx_data(out);
+}
 
-		/* Add the argument */
-		strcpy(&sentence[sentence_ndx], argv[arg_ndx]);
-		sentence_ndx += len;
 
-		if (arg_ndx + 1 >= argc)
-			break;
+/* Send the len characters of data written to nmea_data() */
+void nmea_send_data(unsigned char len)
+{
+	unsigned char  length;
 
-		/* Test if there's space for separator */
-		if (sentence_ndx + len > NMEA_LEN_MAX - NMEA_TRAILER_LEN - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN)
-			return;
+	if (nmea_ctx_seal(outq.sentence[outq_index(outq.used)], len, &length) != NULL)
+		outq_commit(length);
+	outq_work();
+}
 
-		sentence[sentence_ndx] = NMEA_SEPARATOR;
-		sentence_ndx++;
 
-		arg_ndx++;
+unsigned char nmea_valid(void)
+{
+	return (unsigned char)ctx.stat.valid;
+}
+
+
+void nmea_stat(struct nmea_stat_t *nmea_stat)
+{
+	*nmea_stat = ctx.stat;
+}
+
+
+void nmea_drops_reset(void)
+{
+	memset(ctx.stat.drops, 0, sizeof(ctx.stat.drops));
+}
+
+
+#ifdef NMEA_CAPTURE
+/* Keep the fields of the latest sentence that a GPRMC rewrite changed */
+void nmea_capture_out(int argc, char *argv[])
+{
+	unsigned int      start = TMR1;
+	struct capture_t  *entry = &capture[capture_next ? capture_next - 1 : NMEA_CAPTURE_LEN - 1];
+
+	(void)argc;  /* lt_gprmc() verified the fields are there */
+	memcpy(entry->time, argv[NMEA_CAPTURE_TIME], NMEA_CAPTURE_FIELD_LEN);
+	memcpy(entry->date, argv[NMEA_CAPTURE_DATE], NMEA_CAPTURE_FIELD_LEN);
+	entry->out_tick = start;
+	entry->out      = 1;
+	capture_account(start);
+}
+
+
+/*
+ * Print the captured sentences, oldest first, each followed by its rewrite,
+ * a segment of a line per call so a call fits in the console queue. Starts
+ * over for pass 0, returns 0 once all is printed.
+ */
+unsigned char nmea_capture_dump(unsigned char pass)
+{
+	unsigned char     ndx;
+	struct capture_t  *entry;
+
+	if (!pass) {
+		dump_nth  = 0;
+		dump_out  = 0;
+		dump_from = 0;
+	}
+	if (dump_nth >= capture_used)
+		return 0;
+	ndx   = capture_next + NMEA_CAPTURE_LEN - capture_used + dump_nth;
+	entry = &capture[(ndx >= NMEA_CAPTURE_LEN) ? ndx - NMEA_CAPTURE_LEN : ndx];
+
+	if (!dump_from) {
+		if (dump_out)
+			printf("out %.4x ", entry->out_tick);
+		else
+			printf("in  %.4x ", entry->in_tick);
+		putchar(NMEA_HEADER);
 	}
+	if ((dump_from = capture_print(entry, dump_out, dump_from)) == 0) {
+		printf("\n");
+		if (!dump_out && entry->out) {
+			dump_out = 1;
+		} else {
+			dump_out = 0;
+			dump_nth++;
+		}
+	}
+
+	return 1;
+}
 
-	/* Add the checksum separator, the checksum and the trailer */
-	sprintf(&sentence[sentence_ndx], "%c%.2X%c%c", NMEA_CHECKSUM_SEPARATOR, calc_checksum(&sentence[NMEA_HEADER_LEN], sentence_ndx - NMEA_HEADER_LEN), NMEA_TRAILER1, NMEA_TRAILER2);
-	sentence_ndx += NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN + NMEA_TRAILER_LEN;
 
-#ifdef DEBUG
-	printf("Sending '%s'\n", sentence);
-#endif /* DEBUG */
+unsigned int nmea_capture_ticks_max(void)
+{
+	return capture_ticks_max;
+}
+#endif /* NMEA_CAPTURE */
+
 
-	/* Send the sentence to the serial port */
-	for (send_ndx = 0; send_ndx < sentence_ndx; send_ndx++)
-		uart1_putch(sentence[send_ndx]);
+void nmea_outq_policy(enum nmea_outq_policy_t policy)
+{
+	outq.policy = policy;
+}
+
+
+enum nmea_outq_policy_t nmea_outq_get_policy(void)
+{
+	return outq.policy;
+}
+
+
+void nmea_outq_stat(struct nmea_outq_stat_t *stat)
+{
+	*stat      = outq.stat;
+	stat->used = outq.used;
 }
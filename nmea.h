@@ -7,21 +7,75 @@
 #ifndef NMEA_H
 #define NMEA_H
 
+#include "nmeactx.h"
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define NMEA_IN_BITRATE         4800UL  /* Bit rate of the NMEA source (UART1 rx) */
+#define NMEA_OUT_BITRATE        4800UL  /* Bit rate of the NMEA sink */
+
+#if NMEA_OUT_BITRATE != NMEA_IN_BITRATE
+/* A (E)USART has one bit rate generator, so a different output rate moves the output to UART2 tx (muting the console) */
+#define NMEA_OUT_UART2
+#endif
+
+#ifdef NMEA_OUT_UART2
+#define NMEA_OUT_EVENT          EVENT_UART2_TX  /* Posted when a sentence is out, so the next can go */
+#else
+#define NMEA_OUT_EVENT          EVENT_UART1_TX
+#endif /* NMEA_OUT_UART2 */
+
+#define NMEA_OUTQ_LEN           2       /* Number of sentences the output queue holds */
+
+#define NMEA_GPGGA                      /* Also rewrite and forward GPGGA, dated by the GPRMC or GPZDA of the same epoch */
+#define NMEA_GPZDA                      /* Also rewrite and forward GPZDA */
+
+//#define NMEA_AUTOBAUD                 /* Detect the bit rate of the NMEA source, starting at NMEA_IN_BITRATE (needs NMEA_OUT_UART2, or the output would follow) */
+
+//#define NMEA_CAPTURE                  /* Keep the latest sentences received and their rewrites for the 'capture' command, at about 100 bytes of RAM each. Needs UART1_RX_FRAMES 1 to fit */
+#define NMEA_CAPTURE_LEN        1       /* Number of sentences kept */
+
 
 /******************************************************************************/
 /*** Types                                                                  ***/
 /******************************************************************************/
-struct nmea_t {
-	const char  *keyword;
-	void        (*function)(int argc, char *argv[]);
+/* What to do with a new sentence when the output can't keep up with the input */
+enum nmea_outq_policy_t {
+	NMEA_OUTQ_DROP_NEW = 0,             /* Drop the new sentence when the queue is full */
+	NMEA_OUTQ_DROP_OLD,                 /* Drop the oldest sentence not yet being sent when the queue is full */
+	NMEA_OUTQ_LATEST,                   /* Replace a queued sentence of the same type, e.g. keep only the latest RMC, otherwise as NMEA_OUTQ_DROP_OLD */
+	NMEA_OUTQ_TIME_FIRST,               /* Drop the oldest sentence not carrying the time (RMC, GGA, ZDA), or else a new one not carrying it, otherwise as NMEA_OUTQ_DROP_OLD */
+	NMEA_OUTQ_POLICIES
+};
+
+struct nmea_outq_stat_t {
+	unsigned char  used;                /* Sentences currently queued */
+	unsigned char  peak;                /* Highest number of sentences ever queued */
+	unsigned long  queued;              /* Sentences accepted into the queue */
+	unsigned long  dropped;             /* Sentences dropped or replaced by the policy */
 };
 
 
 /******************************************************************************/
 /*** Functions                                                              ***/
 /******************************************************************************/
-void nmea_work(void);
+unsigned char nmea_work(void);
+unsigned char nmea_valid(void);
+void nmea_stat(struct nmea_stat_t *stat);
+void nmea_drops_reset(void);
 void nmea_send(int argc, char *argv[]);
+char *nmea_data(const char *address);
+void nmea_send_data(unsigned char len);
+void nmea_outq_policy(enum nmea_outq_policy_t policy);
+enum nmea_outq_policy_t nmea_outq_get_policy(void);
+void nmea_outq_stat(struct nmea_outq_stat_t *stat);
+#ifdef NMEA_CAPTURE
+void nmea_capture_out(int argc, char *argv[]);
+unsigned char nmea_capture_dump(unsigned char pass);
+unsigned int nmea_capture_ticks_max(void);
+#endif /* NMEA_CAPTURE */
 
 
 #endif /* NMEA_H */
@@ -0,0 +1,379 @@
+/******************************************************************************/
+/* File    : nmeactx.c                                                        */
+/* Function: Reentrant NMEA sentence parser and builder                       */
+/* Author  : Robert Delien, agent                                             */
+/* Copyright (C) 2010, Clockwork Engineering                                  */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* All state lives in a struct nmea_ctx_t, so any number of streams can be    */
+/* handled independently. Doesn't touch any hardware, so it's shared by the   */
+/* firmware (through nmea.c) and the host tools.                              */
+/******************************************************************************/
+#include <string.h>
+
+#include "digits.h"
+#include "trace.h"
+
+#include "nmeactx.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define NMEA_TRAILER1                '\r'
+#define NMEA_TRAILER2                '\n'
+#define NMEA_SEPARATOR               ','
+#define NMEA_CHECKSUM_SEPARATOR      '*'
+
+#define NMEA_ARGS_MAX                15  /* As many as GPGGA has, including the address */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static unsigned char calc_checksum(char *buf, unsigned char len)
+{
+	unsigned char  ndx;
+	unsigned char  calcsum = 0;
+
+	for (ndx = 0; ndx < len; ndx++)
+		calcsum ^= buf[ndx];
+
+	return calcsum;
+}
+
+
+static int keyword2index(const struct nmea_t *nmea, char *keyword)
+{
+	int  ndx = 0;
+
+	while (nmea[ndx].keyword) {
+		if (!strcmp (keyword, nmea[ndx].keyword))
+			return ndx;
+		ndx++;
+	}
+
+	return -1;
+}
+
+
+static void proc_nmea_sentence(struct nmea_ctx_t *ctx, char *sentence, unsigned char len)
+{
+	unsigned char  checksum;
+	unsigned char  calcsum;
+
+	if (len < NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
+		TRACE(TRACE_NMEA_UNDERSIZED, len);
+		ctx->stat.drops[NMEA_DROP_UNDERSIZED]++;
+		return;
+	}
+
+	if (sentence[len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN] != NMEA_CHECKSUM_SEPARATOR) {
+		TRACE(TRACE_NMEA_NO_SEPARATOR, 0);
+		ctx->stat.drops[NMEA_DROP_NO_SEPARATOR]++;
+		return;
+	}
+
+	if (digits_get_hex2(&sentence[len - NMEA_CHECKSUM_LEN], &checksum)) {
+		TRACE(TRACE_NMEA_BAD_HEX, 0);
+		ctx->stat.drops[NMEA_DROP_BAD_HEX]++;
+		return;
+	}
+
+	calcsum = calc_checksum(sentence, len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN);
+	if (calcsum != checksum) {
+		TRACE(TRACE_NMEA_BAD_CHECKSUM, calcsum);
+		ctx->stat.drops[NMEA_DROP_BAD_CHECKSUM]++;
+		return;
+	}
+	ctx->stat.valid++;
+	sentence[len - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN] = '\0';
+
+	nmea_ctx_dispatch(ctx, sentence);
+}
+
+
+/* Have the filter decide on a sentence by its address field, returns non-zero if it's dropped */
+static unsigned char proc_nmea_address(struct nmea_ctx_t *ctx, const char *address)
+{
+	ctx->passing = 0;
+	if (!ctx->filter)
+		return 0;
+
+	switch (ctx->filter(address)) {
+	case NMEA_FILTER_DROP:
+		ctx->stat.filtered++;
+		return 1;
+
+	case NMEA_FILTER_PASS:
+		ctx->passing = 1;
+		break;
+	}
+
+	return 0;
+}
+
+
+/* Handle a sentence framed between header and trailer */
+static void proc_nmea_frame(struct nmea_ctx_t *ctx, char *sentence, unsigned char len, unsigned char lost)
+{
+	ctx->stat.framed++;
+	if (ctx->capture)
+		ctx->capture(ctx, sentence, len);
+	if (lost) {
+		/* The checksum can't be trusted to catch lost characters */
+		TRACE(TRACE_NMEA_LOST, 0);
+		ctx->stat.drops[NMEA_DROP_LOST]++;
+		return;
+	}
+	if (ctx->passing) {
+		/* Leave checking it to the sink */
+		ctx->stat.passed++;
+		if (ctx->pass)
+			ctx->pass(ctx, sentence, len);
+		return;
+	}
+	proc_nmea_sentence(ctx, sentence, len);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/*
+ * Splits a verified, 0-terminated sentence without header and checksum into
+ * arguments in place, and calls the handler for its address field, if any.
+ */
+void nmea_ctx_dispatch(struct nmea_ctx_t *ctx, char *sentence)
+{
+	int   ndx;
+	int   argc = 0;
+	char  *argv[NMEA_ARGS_MAX];
+	char  *start = sentence;
+
+	/* Build argument list */
+	while (*sentence != '\0') {
+		/* Replace leading separators with 0-terminations and add an empty argument for each one */
+		while (*sentence == NMEA_SEPARATOR) {
+			if (argc >= NMEA_ARGS_MAX) {
+				TRACE(TRACE_NMEA_TOO_MANY_ARGS, 0);
+				ctx->stat.drops[NMEA_DROP_TOO_MANY_ARGS]++;
+				return;
+			}
+			*sentence = '\0';
+			argv[argc++] = sentence;
+			sentence++;
+		}
+
+		/* Store the beginning of this argument */
+		if (*sentence != '\0') {
+			if (argc >= NMEA_ARGS_MAX) {
+				TRACE(TRACE_NMEA_TOO_MANY_ARGS, 0);
+				ctx->stat.drops[NMEA_DROP_TOO_MANY_ARGS]++;
+				return;
+			}
+			argv[argc++] = sentence;
+		}
+
+		/* Skip characters until past argument (indicated by a separator or a 0-termination) */
+		while (*sentence != '\0' &&
+		       *sentence != NMEA_SEPARATOR) {
+			sentence++;
+		}
+
+		/* If the argument was terminated by a separator, replace is with a 0-termination */
+		if (*sentence == NMEA_SEPARATOR) {
+			*sentence = '\0';
+			sentence++;
+		}
+	}
+
+	/* A trailing separator is followed by an empty argument, such as the station id of many GPGGA */
+	if (sentence != start && sentence[-1] == '\0') {
+		if (argc >= NMEA_ARGS_MAX) {
+			TRACE(TRACE_NMEA_TOO_MANY_ARGS, 0);
+			ctx->stat.drops[NMEA_DROP_TOO_MANY_ARGS]++;
+			return;
+		}
+		argv[argc++] = sentence;
+	}
+
+	if (argc == 0)
+		return;
+
+	if ((ndx = keyword2index(ctx->nmea, argv[0])) < 0) {
+		TRACE(TRACE_NMEA_UNSUPPORTED, 0);
+		ctx->stat.drops[NMEA_DROP_UNSUPPORTED]++;
+		return;
+	}
+
+	ctx->nmea[ndx].function(ctx, argc, argv);
+}
+
+
+void nmea_ctx_init(struct nmea_ctx_t *ctx, const struct nmea_t *nmea, void *user)
+{
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->nmea = nmea;
+	ctx->user = user;
+}
+
+
+#ifndef NMEA_CTX_FRAMED
+void nmea_ctx_char(struct nmea_ctx_t *ctx, char byte)
+{
+	/* Test if we need to start receiving */
+	if (!ctx->receiving) {
+		switch (byte) {
+		default:
+		case NMEA_TRAILER1:
+			/* What's left of a skipped sentence isn't out of band, up to its trailer */
+			if (!ctx->skipping) {
+				TRACE(TRACE_NMEA_OOB, byte);
+				ctx->stat.drops[NMEA_DROP_OOB]++;
+			}
+			if (byte == NMEA_TRAILER1)
+				ctx->skipping = 0;
+			return;
+
+		case NMEA_TRAILER2:
+			ctx->skipping = 0;
+			return;
+
+		case NMEA_HEADER:
+			/* Start receiving and reset the received length */
+			ctx->receiving = 1;
+			ctx->skipping = 0;
+			ctx->lost = 0;
+			ctx->passing = 0;
+			ctx->len = 0;
+			return;
+		}
+	}
+
+	/* Test if we need to end receiving */
+	if (byte == NMEA_TRAILER2 ||
+	    byte == NMEA_TRAILER1) {
+		ctx->receiving = 0;
+		ctx->sentence[ctx->len] = '\0';
+		proc_nmea_frame(ctx, ctx->sentence, ctx->len, ctx->lost);
+		return;
+	}
+
+	/* Copy the received byte into the current received sentence */
+	if (byte == NMEA_LOST)
+		ctx->lost = 1;
+	ctx->sentence[ctx->len] = byte;
+
+	/* Skip the rest of a sentence the filter doesn't want */
+	if (++ctx->len == NMEA_ADDRESS_LEN && proc_nmea_address(ctx, ctx->sentence)) {
+		ctx->receiving = 0;
+		ctx->skipping = 1;
+		return;
+	}
+
+	if (ctx->len >= NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
+		ctx->receiving = 0;
+		ctx->skipping = 1;
+		ctx->stat.framed++;
+		ctx->sentence[ctx->len] = '\0';
+		TRACE(TRACE_NMEA_OVERSIZED, 0);
+		ctx->stat.drops[NMEA_DROP_OVERSIZED]++;
+	}
+}
+#endif /* NMEA_CTX_FRAMED */
+
+
+/*
+ * Handles a sentence framed elsewhere, such as by the rx interrupt, as
+ * nmea_ctx_char() does at its trailer: what was received between header and
+ * trailer, 0-terminated. It's split up in place.
+ */
+void nmea_ctx_frame(struct nmea_ctx_t *ctx, char *sentence, unsigned char len)
+{
+	if (len >= NMEA_ADDRESS_LEN && proc_nmea_address(ctx, sentence))
+		return;
+	if (len >= NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN) {
+		ctx->stat.framed++;
+		TRACE(TRACE_NMEA_OVERSIZED, 0);
+		ctx->stat.drops[NMEA_DROP_OVERSIZED]++;
+		return;
+	}
+
+	proc_nmea_frame(ctx, sentence, len, memchr(sentence, NMEA_LOST, len) != NULL);
+}
+
+
+/* Where to write the data of a sentence for nmea_ctx_seal() in out, room for NMEA_DATA_LEN_MAX characters and a 0-termination */
+char *nmea_ctx_data(char *out)
+{
+	return &out[NMEA_HEADER_LEN];
+}
+
+
+/*
+ * Completes the len characters of data written to nmea_ctx_data(), address
+ * and arguments with their separators, with header, checksum and trailer.
+ * out needs room for NMEA_LEN_MAX characters and a 0-termination. Returns
+ * out, 0-terminated, or NULL if the data is too long.
+ */
+const char *nmea_ctx_seal(char *out, unsigned char len, unsigned char *length)
+{
+	char  *sentence = out;
+
+	if (len > NMEA_DATA_LEN_MAX)
+		return NULL;
+
+	/* Add the header, the checksum separator, the checksum and the trailer */
+	sentence[0] = NMEA_HEADER;
+	len += NMEA_HEADER_LEN;
+	digits_put_hex2(&sentence[len + NMEA_CHECKSUM_SEPARATOR_LEN], calc_checksum(&sentence[NMEA_HEADER_LEN], len - NMEA_HEADER_LEN));
+	sentence[len] = NMEA_CHECKSUM_SEPARATOR;
+	len += NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN;
+	sentence[len++] = NMEA_TRAILER1;
+	sentence[len++] = NMEA_TRAILER2;
+	sentence[len] = '\0';
+
+	*length = len;
+	return sentence;
+}
+
+
+/*
+ * Builds a complete sentence from the arguments, including header, checksum
+ * and trailer, in out, which needs room for NMEA_LEN_MAX characters and a
+ * 0-termination. Returns out, 0-terminated, or NULL if the sentence doesn't
+ * fit.
+ */
+const char *nmea_ctx_build(char *out, int argc, char *argv[], unsigned char *length)
+{
+	char           *sentence = out;
+	unsigned char  sentence_ndx = NMEA_HEADER_LEN;
+	int            arg_ndx = 0;
+
+	for (;;) {
+		size_t  len = strlen(argv[arg_ndx]);
+
+		/* Test if there's space for the argument */
+		if (sentence_ndx + len > NMEA_LEN_MAX - NMEA_TRAILER_LEN - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN)
+			return NULL;
+
+		/* Add the argument */
+		strcpy(&sentence[sentence_ndx], argv[arg_ndx]);
+		sentence_ndx += len;
+
+		if (arg_ndx + 1 >= argc)
+			break;
+
+		/* Test if there's space for separator */
+		if (sentence_ndx + len > NMEA_LEN_MAX - NMEA_TRAILER_LEN - NMEA_CHECKSUM_LEN - NMEA_CHECKSUM_SEPARATOR_LEN)
+			return NULL;
+
+		sentence[sentence_ndx] = NMEA_SEPARATOR;
+		sentence_ndx++;
+
+		arg_ndx++;
+	}
+
+	return nmea_ctx_seal(out, sentence_ndx - NMEA_HEADER_LEN, length);
+}
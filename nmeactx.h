@@ -0,0 +1,117 @@
+/******************************************************************************/
+/* File    : nmeactx.h                                                        */
+/* Function: Header file of 'nmeactx.c'                                       */
+/* Author  : Robert Delien, agent                                             */
+/* Copyright (C) 2010, Clockwork Engineering                                  */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef NMEACTX_H
+#define NMEACTX_H
+
+#ifndef __x86_64__
+#include "uart1.h"
+#endif /* __x86_64__ */
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define NMEA_HEADER                  '$'
+#define NMEA_LOST                    '\0' /* Stands in for characters lost by the receiver */
+
+#define NMEA_LEN_MAX                 82
+#define NMEA_HEADER_LEN              1
+#define NMEA_ADDRESS_LEN             5   /* Length of the address field, such as 'GPRMC' */
+#define NMEA_TALKER_LEN              2   /* Length of the talker identifier the address field starts with, such as 'GP' */
+#define NMEA_CHECKSUM_SEPARATOR_LEN  1
+#define NMEA_CHECKSUM_LEN            2
+#define NMEA_TRAILER_LEN             2
+#define NMEA_DATA_LEN_MAX            (NMEA_LEN_MAX - NMEA_HEADER_LEN - NMEA_CHECKSUM_SEPARATOR_LEN - NMEA_CHECKSUM_LEN - NMEA_TRAILER_LEN)
+
+/* In the firmware, the rx interrupt may frame the sentences, leaving out nmea_ctx_char() and the buffer it frames into */
+#if !defined(__x86_64__) && UART1_RX_FRAMES
+#define NMEA_CTX_FRAMED
+#endif
+
+#define NMEA_FILTER_PARSE            0   /* Filter decisions: check the sentence and call its handler */
+#define NMEA_FILTER_DROP             1   /* Skip the rest of the sentence */
+#define NMEA_FILTER_PASS             2   /* Hand the sentence to the pass hook as received, unchecked */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+struct nmea_ctx_t;
+
+struct nmea_t {
+	const char  *keyword;
+	void        (*function)(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+};
+
+/* Reasons for the parser to drop a sentence, or for NMEA_DROP_OOB a byte */
+enum nmea_drop_t {
+	NMEA_DROP_OOB = 0,                  /* Bytes between sentences, other than trailers */
+	NMEA_DROP_OVERSIZED,                /* No trailer within the maximum length */
+	NMEA_DROP_LOST,                     /* Characters lost by the receiver */
+	NMEA_DROP_UNDERSIZED,               /* Too short to hold a checksum */
+	NMEA_DROP_NO_SEPARATOR,             /* No checksum separator in front of the checksum */
+	NMEA_DROP_BAD_HEX,                  /* Checksum not two hex digits */
+	NMEA_DROP_BAD_CHECKSUM,             /* Checksum doesn't match */
+	NMEA_DROP_TOO_MANY_ARGS,            /* More arguments than any supported sentence has */
+	NMEA_DROP_UNSUPPORTED,              /* Valid, but no handler for its address field */
+	NMEA_DROPS
+};
+
+struct nmea_stat_t {
+	unsigned long  framed;              /* Sentences received between header and trailer, or cut off at maximum length */
+	unsigned long  valid;               /* Sentences with a good checksum */
+	unsigned long  filtered;            /* Sentences dropped by the filter after their address field, not counted as framed */
+	unsigned long  passed;              /* Sentences handed to the pass hook */
+	unsigned int   drops[NMEA_DROPS];   /* Sentences dropped by the parser, by enum nmea_drop_t. Wrap around like the UART error counts */
+};
+
+/* Everything needed to process one NMEA stream */
+struct nmea_ctx_t {
+	const struct nmea_t  *nmea;         /* Sentence handlers, terminated by a NULL keyword */
+	void                 *user;         /* For use by the handlers */
+	void                 (*capture)(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len);  /* If set, gets every sentence framed by nmea_ctx_char() or handed to nmea_ctx_frame() before it's checked */
+	unsigned char        (*filter)(const char *address);  /* If set, decides on every sentence once its address field is in, returns NMEA_FILTER_* */
+	void                 (*pass)(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len);  /* Gets the sentences the filter passes, with checksum but without header and trailer */
+	unsigned char        passing;       /* The filter passes the current sentence */
+#ifndef NMEA_CTX_FRAMED
+	char                 sentence[NMEA_DATA_LEN_MAX + NMEA_CHECKSUM_SEPARATOR_LEN + NMEA_CHECKSUM_LEN + 1];
+	unsigned char        len;           /* Number of bytes in sentence */
+	unsigned char        receiving;     /* A header was received, but no trailer yet */
+	unsigned char        lost;          /* Characters of the current sentence were lost */
+	unsigned char        skipping;      /* The rest of a dropped sentence is skipped up to its trailer, rather than counted out of band */
+#endif /* NMEA_CTX_FRAMED */
+	struct nmea_stat_t   stat;
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void       nmea_ctx_init (struct nmea_ctx_t    *ctx,
+                          const struct nmea_t  *nmea,
+                          void                 *user);
+#ifndef NMEA_CTX_FRAMED
+void       nmea_ctx_char (struct nmea_ctx_t    *ctx,
+                          char                 byte);
+#endif /* NMEA_CTX_FRAMED */
+void       nmea_ctx_frame(struct nmea_ctx_t    *ctx,
+                          char                 *sentence,
+                          unsigned char        len);
+void       nmea_ctx_dispatch(struct nmea_ctx_t *ctx,
+                          char                 *sentence);
+char       *nmea_ctx_data(char                 *out);
+const char *nmea_ctx_seal(char                 *out,
+                          unsigned char        len,
+                          unsigned char        *length);
+const char *nmea_ctx_build(char                *out,
+                          int                  argc,
+                          char                 *argv[],
+                          unsigned char        *length);
+
+
+#endif /* NMEACTX_H */
@@ -0,0 +1,242 @@
+/******************************************************************************/
+/* File    : persist.c                                                        */
+/* Function: Wear-levelled storage of calibration data in High-Endurance Flash*/
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* The PIC16F15325 has 128 words of High-Endurance Flash (HEF) at the end of  */
+/* program memory, of which only the low byte of each word is high-endurance. */
+/* It is used as a ring of 16 records of 8 bytes, each save going into the   */
+/* next slot. The latest record is the valid one followed by an erased slot.  */
+/* Before the last slot of a row is written, the next row is erased, so even a*/
+/* power loss right after that write leaves an erased slot after the latest   */
+/* record, and every row wears at the same rate. Note that the CPU stalls for */
+/* a few milliseconds during erase and write. Only used with HAS_RTC (main.c),*/
+/* which the default build doesn't define.                                    */
+/******************************************************************************/
+#include <xc.h>
+
+#include "persist.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define HEF_START               0x1F80  /* First word of HEF */
+#define HEF_ROW_WORDS           32      /* Erase and write latch size */
+
+#define RECORD_LEN              8       /* Words per record, one byte each */
+#define RECORDS                 16      /* (128 / RECORD_LEN) */
+#define RECORDS_PER_ROW         (HEF_ROW_WORDS / RECORD_LEN)
+
+#define REC_TUNE                0       /* 6 bits, so an erased (0xff) slot is never valid */
+#define REC_DRIFT               1       /* 2 bytes, little endian */
+#define REC_TIME                3       /* 4 bytes, little endian */
+#define REC_CHECK               7       /* XOR of all other bytes and CHECK_SEED */
+
+#define CHECK_SEED              0x5a
+#define ERASED                  0xff
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static unsigned char  latest = RECORDS;  /* Slot of the latest valid record, RECORDS if none */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void nvm_unlock(void)
+{
+	unsigned char  gie = GIE;
+
+	/* The unlock sequence must not be interrupted */
+	GIE = 0;
+	NVMCON2 = 0x55;
+	NVMCON2 = 0xAA;
+	NVMCON1bits.WR = 1;  /* The CPU stalls until the operation completes */
+	NOP();
+	NOP();
+	GIE = gie;
+}
+
+
+static void nvm_address(unsigned int addr)
+{
+	NVMCON1bits.NVMREGS = 0;  /* Program flash memory */
+	NVMADRH = (unsigned char)(addr >> 8);
+	NVMADRL = (unsigned char)addr;
+}
+
+
+static void read_record(unsigned char slot, unsigned char *rec)
+{
+	unsigned char  ndx;
+
+	for (ndx = 0; ndx < RECORD_LEN; ndx++) {
+		nvm_address(HEF_START + slot * RECORD_LEN + ndx);
+		NVMCON1bits.RD = 1;
+		rec[ndx] = NVMDATL;
+	}
+}
+
+
+static void erase_row(unsigned char slot)
+{
+	nvm_address(HEF_START + slot * RECORD_LEN);
+	NVMCON1bits.FREE = 1;
+	NVMCON1bits.WREN = 1;
+	nvm_unlock();
+	NVMCON1bits.FREE = 0;
+	NVMCON1bits.WREN = 0;
+}
+
+
+static void write_record(unsigned char slot, const unsigned char *rec)
+{
+	unsigned char  ndx;
+
+	/* Load the write latches and write them with the last one, latches not loaded leave their (erased) words untouched */
+	NVMCON1bits.WREN = 1;
+	NVMCON1bits.LWLO = 1;
+	for (ndx = 0; ndx < RECORD_LEN; ndx++) {
+		nvm_address(HEF_START + slot * RECORD_LEN + ndx);
+		NVMDATH = 0x3f;
+		NVMDATL = rec[ndx];
+		if (ndx == RECORD_LEN - 1)
+			NVMCON1bits.LWLO = 0;
+		nvm_unlock();
+	}
+	NVMCON1bits.WREN = 0;
+}
+
+
+static unsigned char check_record(const unsigned char *rec)
+{
+	unsigned char  ndx;
+	unsigned char  check = CHECK_SEED;
+
+	for (ndx = 0; ndx < REC_CHECK; ndx++)
+		check ^= rec[ndx];
+
+	return check;
+}
+
+
+static unsigned char valid_record(unsigned char slot)
+{
+	unsigned char  rec[RECORD_LEN];
+
+	read_record(slot, rec);
+
+	return rec[REC_TUNE] != ERASED && rec[REC_CHECK] == check_record(rec);
+}
+
+
+static unsigned char erased_record(unsigned char slot)
+{
+	unsigned char  rec[RECORD_LEN];
+	unsigned char  ndx;
+
+	read_record(slot, rec);
+	for (ndx = 0; ndx < RECORD_LEN; ndx++)
+		if (rec[ndx] != ERASED)
+			return 0;
+
+	return 1;
+}
+
+
+static unsigned long record_time(const unsigned char *rec)
+{
+	return  (unsigned long)rec[REC_TIME]             |
+	       ((unsigned long)rec[REC_TIME + 1] <<  8) |
+	       ((unsigned long)rec[REC_TIME + 2] << 16) |
+	       ((unsigned long)rec[REC_TIME + 3] << 24);
+}
+
+
+/* Slot of the valid record with the latest time, RECORDS if there is none */
+static unsigned char newest_record(void)
+{
+	unsigned char  rec[RECORD_LEN];
+	unsigned char  newest = RECORDS;
+	unsigned long  newest_time = 0;
+	unsigned char  slot;
+
+	for (slot = 0; slot < RECORDS; slot++) {
+		if (!valid_record(slot))
+			continue;
+		read_record(slot, rec);
+		if (newest == RECORDS || record_time(rec) >= newest_time) {
+			newest      = slot;
+			newest_time = record_time(rec);
+		}
+	}
+
+	return newest;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/* Load the latest valid record, returns -1 if there is none */
+int persist_load(struct persist_t *data)
+{
+	unsigned char  rec[RECORD_LEN];
+	unsigned char  slot;
+
+	/* Find the valid record followed by an invalid one, usually erased, but possibly left half-written by a power loss */
+	latest = RECORDS;
+	for (slot = 0; slot < RECORDS; slot++) {
+		if (valid_record(slot) && !valid_record((slot + 1) % RECORDS)) {
+			latest = slot;
+			break;
+		}
+	}
+	/* A ring left without an erased slot (by an earlier version) has no such pair, take the latest time instead */
+	if (latest == RECORDS)
+		latest = newest_record();
+	if (latest == RECORDS)
+		return -1;
+
+	read_record(latest, rec);
+	data->tune  = rec[REC_TUNE];
+	data->drift = (int)(rec[REC_DRIFT] | ((unsigned int)rec[REC_DRIFT + 1] << 8));
+	data->time  = record_time(rec);
+
+	return 0;
+}
+
+
+/* Save a record into the next slot */
+void persist_save(const struct persist_t *data)
+{
+	unsigned char  rec[RECORD_LEN];
+	unsigned char  slot = (latest < RECORDS) ? (latest + 1) % RECORDS : 0;
+
+	/* Never program over a slot that isn't erased, start over at a freshly erased row instead */
+	if (!erased_record(slot)) {
+		if (slot % RECORDS_PER_ROW)
+			slot = (slot / RECORDS_PER_ROW + 1) * RECORDS_PER_ROW % RECORDS;
+		erase_row(slot);
+	}
+
+	rec[REC_TUNE]      = data->tune & 0x3f;
+	rec[REC_DRIFT]     = (unsigned char)data->drift;
+	rec[REC_DRIFT + 1] = (unsigned char)((unsigned int)data->drift >> 8);
+	rec[REC_TIME]      = (unsigned char)data->time;
+	rec[REC_TIME + 1]  = (unsigned char)(data->time >> 8);
+	rec[REC_TIME + 2]  = (unsigned char)(data->time >> 16);
+	rec[REC_TIME + 3]  = (unsigned char)(data->time >> 24);
+	rec[REC_CHECK]     = check_record(rec);
+
+	/* Erase the next row before filling up this one, so an erased slot follows the latest record whenever the power fails */
+	if (slot % RECORDS_PER_ROW == RECORDS_PER_ROW - 1)
+		erase_row((slot + 1) % RECORDS);
+
+	write_record(slot, rec);
+	latest = slot;
+}
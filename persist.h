@@ -0,0 +1,28 @@
+/******************************************************************************/
+/* File    : persist.h                                                        */
+/* Function: Header file of 'persist.c'                                       */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef PERSIST_H
+#define PERSIST_H
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+struct persist_t {
+	unsigned char  tune;                /* Converged OSCTUNE.HFTUN value */
+	int            drift;               /* Last measured deviation in ms */
+	unsigned long  time;                /* Last valid UTC time in seconds since Epoch */
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+int           persist_load  (struct persist_t        *data);
+void          persist_save  (const struct persist_t  *data);
+
+
+#endif /* PERSIST_H */
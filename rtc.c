@@ -1,6 +1,10 @@
-#include <xc.h>
+#if !defined(__x86_64__) || defined(HAS_RTC)
+#include <xc.h>  /* On the host, the RTC needs the register emulation of the tests */
+#endif /* !__x86_64__ || HAS_RTC */
 
 #include "rtc.h"
+#include "event.h"
+#include "persist.h"
 
 
 /******************************************************************************/
@@ -22,6 +26,9 @@
 
 #define TICKS_PER_SECOND        1000U
 
+#define PERSIST_INTERVAL_S      (1 * SECONDS_PER_HOUR)  /* Minimum time between saves of calibration data, to limit flash wear */
+#define DRIFT_MAX               32767
+
 //#define TEST_DST
 #define ARRAY_SIZE(x)           (sizeof(x) / sizeof((x)[0]))
 
@@ -29,8 +36,13 @@
 /******************************************************************************/
 /* Global Data                                                                */
 /******************************************************************************/
+#ifdef HAS_RTC
+/* The clock of the one oscillator there is, so deliberately global */
 static volatile rtcsecs_t      rtc = 0;
 static volatile unsigned int   ticks;
+static long                    drift;          /* Last measured deviation in ms */
+static rtcsecs_t               saved_utc = 0;  /* Time of the last save of calibration data */
+#endif /* HAS_RTC */
 
 
 /******************************************************************************/
@@ -81,6 +93,7 @@ static inline void calibrate(rtcsecs_t elapsed, long deviation, unsigned int act
 			deviation = TICKS_PER_SECOND * (deviation + 1) - (TICKS_PER_SECOND - actual_ticks);
 		else
 			deviation = TICKS_PER_SECOND * deviation + actual_ticks;
+		drift = deviation;
 
 		/* Tune the internal oscillator accordingly */
 		if (deviation < 0) {
@@ -105,6 +118,7 @@ void rtc_isr (void)
 		return;
 	ticks = 0;
 	rtc++;
+	event_post(EVENT_RTC_SECOND);
 }
 
 
@@ -141,10 +155,43 @@ void rtc_set_time(rtcsecs_t utc)
 	/* (Re-)enable timer 0 interrupt */
 	TMR0IE = 1;
 
-	if (prev_utc)
+	if (prev_utc) {
 		calibrate(utc - prev_utc, actual_rtc - utc, actual_ticks);  /* TODO: Improve subtraction of two unsigneds into signed for argument 2 */
+
+		/* Save the calibration, so the next boot starts calibrated */
+		if (!saved_utc || utc - saved_utc >= PERSIST_INTERVAL_S) {
+			struct persist_t  data;
+
+			data.tune  = OSCTUNEbits.HFTUN;
+			data.drift = (drift > DRIFT_MAX) ? DRIFT_MAX : (drift < -DRIFT_MAX) ? -DRIFT_MAX : (int)drift;
+			data.time  = utc;
+			persist_save(&data);
+			saved_utc = utc;
+		}
+	}
 	prev_utc = utc;
 }
+
+
+/* Restore the calibration and last valid time saved by a previous run */
+void rtc_restore(void)
+{
+	struct persist_t  data;
+
+	if (persist_load(&data))
+		return;
+
+	OSCTUNEbits.HFTUN = data.tune;
+	drift             = data.drift;
+	rtc               = data.time;  /* Stale, but closer than Epoch until the first update */
+	saved_utc         = data.time;
+}
+
+
+long rtc_drift(void)
+{
+	return drift;
+}
 #endif /* HAS_RTC */
 
 
@@ -40,6 +40,8 @@ struct rtctime_t {
 /******************************************************************************/
 void          rtc_isr        (void);
 void          rtc_set_time   (rtcsecs_t               utc);
+void          rtc_restore    (void);
+long          rtc_drift      (void);
 int           rtc_time2secs  (const struct rtctime_t  *rtctime,
                               rtcsecs_t               *rtcsecs);
 void          rtc_secs2time  (rtcsecs_t               rtcsecs,
@@ -0,0 +1,111 @@
+/******************************************************************************/
+/* File    : sched.c                                                          */
+/* Function: Cooperative run-to-completion task scheduler                     */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Tasks are listed in the tasks[] table in order of priority. A task becomes */
+/* ready when one of its events is posted, or when it reports that it left   */
+/* work undone. Each pass runs only the highest-priority ready task, so a     */
+/* lower-priority task delays a higher-priority one by at most one bounded    */
+/* run.                                                                       */
+/******************************************************************************/
+#ifndef __x86_64__
+#include <xc.h>
+#endif /* __x86_64__ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "event.h"
+#include "sched.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+//#define EVENT_LOOP                    /* Idle until an interrupt posts an event, instead of polling all tasks */
+
+#ifdef __x86_64__
+#define SCHED_NOW()             sched_now_hook()
+#else
+#define SCHED_NOW()             TMR1    /* Free-running at Fosc/4, see init_timebase() */
+#endif /* __x86_64__ */
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+extern const struct task_t  tasks[];
+#ifdef __x86_64__
+extern unsigned int         sched_now_hook(void);
+#endif /* __x86_64__ */
+static unsigned char        ready;
+static struct task_stat_t   stats[SCHED_TASKS_MAX];
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void sched_init(void)
+{
+	ready = 0;
+	sched_reset_stats();
+#ifdef EVENT_LOOP
+	event_init();
+#endif /* EVENT_LOOP */
+}
+
+
+void sched_run(void)
+{
+	unsigned char  events;
+	unsigned char  ndx;
+	unsigned char  mask;
+
+#ifdef EVENT_LOOP
+	/* Only idle if there's nothing left to do */
+	events = ready ? event_get() : event_wait();
+#else
+	/* Without events, start a new round through all tasks when the previous one completed */
+	events = ready ? event_get() : 0xff;
+#endif /* EVENT_LOOP */
+
+	/* Make the tasks ready that are interested in these events */
+	for (ndx = 0, mask = 1; ndx < SCHED_TASKS_MAX && tasks[ndx].function; ndx++, mask <<= 1)
+		if (tasks[ndx].events & events)
+			ready |= mask;
+
+	/* Run the highest-priority ready task once */
+	for (ndx = 0, mask = 1; ndx < SCHED_TASKS_MAX && tasks[ndx].function; ndx++, mask <<= 1) {
+		if (ready & mask) {
+			struct task_stat_t  *stat = &stats[ndx];
+			unsigned int        start;
+			unsigned int        ticks;
+
+			ready &= ~mask;
+			start = SCHED_NOW();
+			if (tasks[ndx].function())
+				ready |= mask;
+			ticks = SCHED_NOW() - start;
+
+			stat->runs++;
+			stat->ticks += ticks;
+			if (ticks > stat->ticks_max)
+				stat->ticks_max = ticks;
+			return;
+		}
+	}
+}
+
+
+const struct task_stat_t *sched_stat(unsigned char ndx)
+{
+	return (ndx < SCHED_TASKS_MAX) ? &stats[ndx] : NULL;
+}
+
+
+void sched_reset_stats(void)
+{
+	memset(stats, 0, sizeof(stats));
+}
@@ -0,0 +1,42 @@
+/******************************************************************************/
+/* File    : sched.h                                                          */
+/* Function: Header file of 'sched.c'                                         */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef SCHED_H
+#define SCHED_H
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define SCHED_TASKS_MAX         4       /* Maximum number of tasks, as many as main.c has with all options. No more than 8, one bit each in the ready mask */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+struct task_t {
+	const char     *name;
+	unsigned char  events;              /* Events that make this task ready */
+	unsigned char  (*function)(void);   /* Does a bounded amount of work, returns non-zero if work was left */
+};
+
+struct task_stat_t {
+	unsigned long  runs;                /* Number of times the task ran */
+	unsigned long  ticks;               /* Accumulated run time in timer ticks */
+	unsigned int   ticks_max;           /* Longest single run in timer ticks */
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void                      sched_init (void);
+void                      sched_run  (void);
+const struct task_stat_t  *sched_stat(unsigned char  ndx);
+void                      sched_reset_stats(void);
+
+
+#endif /* SCHED_H */
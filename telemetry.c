@@ -0,0 +1,285 @@
+/******************************************************************************/
+/* File    : telemetry.c                                                      */
+/* Function: Periodic machine-readable status records                         */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Every so many GPRMC epochs, a proprietary NMEA sentence is emitted:        */
+/*                                                                            */
+/* $PCWET,seq,framed,valid,queued,dropped,rxerr,hhmmss,offset,dst,drift,      */
+/*        lat,latmax*hh                                                       */
+/*                                                                            */
+/* seq     Record sequence number, wraps at 65536                             */
+/* framed  NMEA sentences received, wraps at 65536                            */
+/* valid   NMEA sentences received with a good checksum, wraps at 65536       */
+/* queued  Sentences accepted into the output queue, wraps at 65536           */
+/* dropped Sentences dropped by the output queue, wraps at 65536              */
+/* rxerr   UART1 overrun and framing errors, wraps at 65536                   */
+/* hhmmss  UTC time of the last epoch                                         */
+/* offset  Local time offset to UTC in minutes, including DST                 */
+/* dst     1 if daylight saving time is in effect                             */
+/* drift   Last measured RTC deviation in ms, clipped to +/-32767, empty      */
+/*         without RTC                                                        */
+/* lat     GPRMC conversion time of the last epoch in TMR1 ticks (Fosc/4)     */
+/* latmax  Longest GPRMC conversion time since the previous record            */
+/*                                                                            */
+/* The record is formatted a few fields at a time with the digit helpers. If  */
+/* the NMEA output replaced the console on UART2, it goes into the NMEA       */
+/* output queue right away, which doesn't wait. Otherwise the GPRMC path only */
+/* notes the epoch, and the record is printed on the console like a command   */
+/* reply, a part per pass once the command line is idle and the console queue */
+/* has room, so it neither stalls the main loop nor mixes with replies. An    */
+/* epoch due for a record while the previous one is still waiting is counted  */
+/* as dropped instead.                                                        */
+/******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "nmea.h"
+#include "uart1.h"
+#include "cmdline.h"
+#include "digits.h"
+
+#include "telemetry.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define TELEMETRY_DRIFT_MAX     32767L  /* Drift is clipped to what a decimal int holds */
+#define TELEMETRY_PARTS         3       /* Parts a record is formatted in */
+#define TELEMETRY_PART_LEN      28      /* Longest part: ",-32767,1,-32767,65535,65535" */
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+/* What the epoch reported, for the record formatted later */
+struct record_t {
+	unsigned int   seq;
+	rtcsecs_t      utc;
+	int            offset_m;
+	unsigned char  dst;
+	unsigned int   latency;
+	unsigned int   latency_max;
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static unsigned char    interval;       /* Epochs between records, 0 when disabled */
+static unsigned char    epochs;         /* Epochs since the previous record */
+static unsigned int     seq;
+static unsigned int     latency_max;
+static struct record_t  record;
+#ifndef NMEA_OUT_UART2
+static unsigned char    waiting;        /* The record is still waiting to be printed */
+static unsigned char    checksum;       /* Of the parts printed so far */
+static unsigned int     dropped;        /* Records dropped as the previous one was still waiting */
+#endif /* NMEA_OUT_UART2 */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static unsigned char put_unsigned(char *str, unsigned int value)
+{
+	str[0] = ',';
+
+	return 1 + digits_put_dec(&str[1], value);
+}
+
+
+static unsigned char put_signed(char *str, int value)
+{
+	if (value >= 0)
+		return put_unsigned(str, (unsigned int)value);
+
+	str[0] = ',';
+	str[1] = '-';
+
+	return 2 + digits_put_dec(&str[2], 0U - (unsigned int)value);
+}
+
+
+/* Address, sequence number and parser counts */
+static unsigned char put_counts(char *str)
+{
+	struct nmea_stat_t  stat;
+	unsigned char       len = sizeof(TELEMETRY_ADDRESS) - 1;
+
+	nmea_stat(&stat);
+	memcpy(str, TELEMETRY_ADDRESS, len);
+	len += put_unsigned(&str[len], record.seq);
+	len += put_unsigned(&str[len], (unsigned int)stat.framed);
+	len += put_unsigned(&str[len], (unsigned int)stat.valid);
+
+	return len;
+}
+
+
+/* Output queue and receive error counts, and the time of the epoch */
+static unsigned char put_queue(char *str)
+{
+	struct nmea_outq_stat_t  stat;
+	unsigned char            len;
+	unsigned long            secs = record.utc % SECONDS_PER_DAY;
+
+	nmea_outq_stat(&stat);
+	len  = put_unsigned(str, (unsigned int)stat.queued);
+	len += put_unsigned(&str[len], (unsigned int)stat.dropped);
+	len += put_unsigned(&str[len], uart1_rx_errors());
+	str[len++] = ',';
+	digits_put_dec2(&str[len],     (unsigned char)(secs / SECONDS_PER_HOUR));
+	digits_put_dec2(&str[len + 2], (unsigned char)(secs / SECONDS_PER_MINUTE % MINUTES_PER_HOUR));
+	digits_put_dec2(&str[len + 4], (unsigned char)(secs % SECONDS_PER_MINUTE));
+
+	return len + 6;
+}
+
+
+/* Offset, DST, drift and latencies */
+static unsigned char put_timing(char *str)
+{
+	unsigned char  len;
+#ifdef HAS_RTC
+	long           drift = rtc_drift();
+#endif /* HAS_RTC */
+
+	len  = put_signed(str, record.offset_m);
+	len += put_unsigned(&str[len], record.dst ? 1 : 0);
+#ifdef HAS_RTC
+	if (drift > TELEMETRY_DRIFT_MAX)
+		drift = TELEMETRY_DRIFT_MAX;
+	else if (drift < -TELEMETRY_DRIFT_MAX)
+		drift = -TELEMETRY_DRIFT_MAX;
+	len += put_signed(&str[len], (int)drift);
+#else
+	str[len++] = ',';
+#endif /* HAS_RTC */
+	len += put_unsigned(&str[len], record.latency);
+	len += put_unsigned(&str[len], record.latency_max);
+
+	return len;
+}
+
+
+/* Write a part of the record, no more than TELEMETRY_PART_LEN characters, returns its length */
+static unsigned char put_part(char *str, unsigned char part)
+{
+	switch (part) {
+	case 0:
+		return put_counts(str);
+	case 1:
+		return put_queue(str);
+	default:
+		return put_timing(str);
+	}
+}
+
+
+#ifndef NMEA_OUT_UART2
+/* Print the record a part per pass, run by the command line */
+static int print_record(int argc, char *argv[])
+{
+	char           part[TELEMETRY_PART_LEN];
+	unsigned char  pass = cmdline_pass();
+	unsigned char  len  = put_part(part, pass);
+	unsigned char  ndx;
+
+	if (!pass) {
+		putchar(NMEA_HEADER);
+		checksum = 0;
+	}
+	for (ndx = 0; ndx < len; ndx++) {
+		putchar(part[ndx]);
+		checksum ^= part[ndx];
+	}
+	if (pass + 1 < TELEMETRY_PARTS)
+		return ERR_MORE;
+
+	/* Checksum and trailer */
+	part[0] = '*';
+	digits_put_hex2(&part[1], checksum);
+	part[3] = '\r';
+	part[4] = '\n';
+	for (ndx = 0; ndx < 5; ndx++)
+		putchar(part[ndx]);
+	waiting = 0;
+
+	return ERR_OK;
+}
+#endif /* NMEA_OUT_UART2 */
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void telemetry_interval(unsigned char count)
+{
+	interval = count;
+	epochs   = 0;
+}
+
+
+unsigned char telemetry_get_interval(void)
+{
+	return interval;
+}
+
+
+/* Records dropped as the previous one was still waiting for the console */
+unsigned int telemetry_dropped(void)
+{
+#ifdef NMEA_OUT_UART2
+	return 0;
+#else
+	return dropped;
+#endif /* NMEA_OUT_UART2 */
+}
+
+
+void telemetry_epoch(rtcsecs_t utc, int offset_m, unsigned char dst, unsigned int latency)
+{
+#ifdef NMEA_OUT_UART2
+	char           *data;
+	unsigned char  len;
+	unsigned char  part;
+#endif /* NMEA_OUT_UART2 */
+
+	if (latency > latency_max)
+		latency_max = latency;
+
+	if (!interval || ++epochs < interval)
+		return;
+	epochs = 0;
+
+#ifndef NMEA_OUT_UART2
+	/* A dropped record leaves a gap in the sequence numbers */
+	if (waiting) {
+		seq++;
+		dropped++;
+		return;
+	}
+#endif /* NMEA_OUT_UART2 */
+	record.seq         = seq++;
+	record.utc         = utc;
+	record.offset_m    = offset_m;
+	record.dst         = dst;
+	record.latency     = latency;
+	record.latency_max = latency_max;
+	latency_max = 0;
+
+#ifdef NMEA_OUT_UART2
+	/* Straight into the NMEA output queue, at its longest it takes up all of NMEA_DATA_LEN_MAX */
+	if ((data = nmea_data(TELEMETRY_ADDRESS)) == NULL)
+		return;
+	for (len = 0, part = 0; part < TELEMETRY_PARTS; part++)
+		len += put_part(&data[len], part);
+	nmea_send_data(len);
+#else
+	waiting = 1;
+	cmdline_post(print_record);
+#endif /* NMEA_OUT_UART2 */
+}
@@ -0,0 +1,32 @@
+/******************************************************************************/
+/* File    : telemetry.h                                                      */
+/* Function: Header file of 'telemetry.c'                                     */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include "rtc.h"
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define TELEMETRY_ADDRESS       "PCWET" /* Proprietary sentence: 'P', manufacturer 'CWE' (Clockwork Engineering), type 'T' */
+#define TELEMETRY_INTERVAL      10      /* Default number of GPRMC epochs between records */
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void          telemetry_interval    (unsigned char  count);
+unsigned char telemetry_get_interval(void);
+unsigned int  telemetry_dropped     (void);
+void          telemetry_epoch       (rtcsecs_t      utc,
+                                     int            offset_m,
+                                     unsigned char  dst,
+                                     unsigned int   latency);
+
+
+#endif /* TELEMETRY_H */
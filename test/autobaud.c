@@ -0,0 +1 @@
+../autobaud.c
\ No newline at end of file
@@ -0,0 +1 @@
+../autobaud.h
\ No newline at end of file
@@ -0,0 +1,210 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "digits.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define ITERATIONS              10000000UL
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+
+/* Reference implementation of get_octets(), as it was before using strtoul() */
+static int get_octets_libc(char *str, unsigned char octet[])
+{
+	int  ndx;
+
+	for (ndx = 4; ndx >= 0; ndx -= 2) {
+		char           *endptr;
+		unsigned long  value = strtoul(&str[ndx], &endptr, 10);
+
+		if (*endptr != '\0')
+			return -1;
+		octet[ndx >> 1] = (unsigned char)value;
+		str[ndx] = '\0';
+	}
+
+	return 0;
+}
+
+
+/* Implementation of get_octets() using fixed-width digit conversion */
+static int get_octets_digits(const char *str, unsigned char octet[])
+{
+	unsigned char  ndx;
+
+	for (ndx = 0; ndx < 3; ndx++)
+		if (digits_get_dec2(&str[ndx << 1], &octet[ndx]))
+			return -1;
+
+	return str[6] != '\0' ? -1 : 0;
+}
+
+
+static void test_conversions(void)
+{
+	char           buf[8];
+	char           ref[8];
+	unsigned int   value;
+	unsigned char  result;
+	unsigned int   ch;
+
+	/* Test all decimal values, including wrap-around beyond 99 */
+	for (value = 0; value < 256; value++) {
+		digits_put_dec2(buf, (unsigned char)value);
+		sprintf(ref, "%02u", value % 100);
+		if (memcmp(buf, ref, 2)) {
+			fprintf(stderr, "Error: digits_put_dec2() produced %.2s, expected %s for %u\n", buf, ref, value);
+			exit(EXIT_FAILURE);
+		}
+		if (value < 100 && (digits_get_dec2(ref, &result) || result != value)) {
+			fprintf(stderr, "Error: digits_get_dec2() failed for %s\n", ref);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Test all variable-width decimal values */
+	for (value = 0; value <= 0xffff; value++) {
+		unsigned char  len = digits_put_dec(buf, value);
+
+		if (len != sprintf(ref, "%u", value) || memcmp(buf, ref, len)) {
+			fprintf(stderr, "Error: digits_put_dec() produced %.*s, expected %s\n", len, buf, ref);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Test all hexadecimal values, in both cases */
+	for (value = 0; value < 256; value++) {
+		digits_put_hex2(buf, (unsigned char)value);
+		sprintf(ref, "%.2X", value);
+		if (memcmp(buf, ref, 2)) {
+			fprintf(stderr, "Error: digits_put_hex2() produced %.2s, expected %s for %u\n", buf, ref, value);
+			exit(EXIT_FAILURE);
+		}
+		if (digits_get_hex2(ref, &result) || result != value) {
+			fprintf(stderr, "Error: digits_get_hex2() failed for %s\n", ref);
+			exit(EXIT_FAILURE);
+		}
+		sprintf(ref, "%.2x", value);
+		if (digits_get_hex2(ref, &result) || result != value) {
+			fprintf(stderr, "Error: digits_get_hex2() failed for %s\n", ref);
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	/* Test rejection of every non-digit character in either position */
+	for (ch = 1; ch < 256; ch++) {
+		unsigned char  isdec = ch >= '0' && ch <= '9';
+		unsigned char  ishex = isdec || (ch >= 'A' && ch <= 'F') || (ch >= 'a' && ch <= 'f');
+
+		buf[0] = '0';
+		buf[1] = (char)ch;
+		if ((digits_get_dec2(buf, &result) == 0) != isdec ||
+		    (digits_get_hex2(buf, &result) == 0) != ishex) {
+			fprintf(stderr, "Error: wrong validation of character 0x%02x in position 1\n", ch);
+			exit(EXIT_FAILURE);
+		}
+		buf[0] = (char)ch;
+		buf[1] = '0';
+		if ((digits_get_dec2(buf, &result) == 0) != isdec ||
+		    (digits_get_hex2(buf, &result) == 0) != ishex) {
+			fprintf(stderr, "Error: wrong validation of character 0x%02x in position 0\n", ch);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	static const char  time_str[] = "235959";
+	char               buf[16];
+	unsigned char      octet[3];
+	unsigned long      sum = 0;
+	unsigned long      ndx;
+	struct timespec    start;
+	struct timespec    end;
+
+	test_conversions();
+	fprintf(stderr, "Conversion test completed successfully\n");
+
+	/* Benchmark parsing of a time field */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		memcpy(buf, time_str, sizeof(time_str));
+		buf[5] = '0' + ndx % 10;
+		get_octets_libc(buf, octet);
+		sum += octet[2];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("get_octets, strtoul():         %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		memcpy(buf, time_str, sizeof(time_str));
+		buf[5] = '0' + ndx % 10;
+		get_octets_digits(buf, octet);
+		sum += octet[2];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("get_octets, digits_get_dec2(): %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	/* Benchmark formatting of a time field */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		sprintf(buf, "%02d%02d%02d", (int)(ndx % 24), (int)(ndx % 60), (int)(ndx % 61));
+		sum += buf[5];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("time field, sprintf():         %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		digits_put_dec2(&buf[0], (unsigned char)(ndx % 24));
+		digits_put_dec2(&buf[2], (unsigned char)(ndx % 60));
+		digits_put_dec2(&buf[4], (unsigned char)(ndx % 61));
+		sum += buf[5];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("time field, digits_put_dec2(): %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	/* Benchmark formatting of a checksum */
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		sprintf(buf, "%c%.2X%c%c", '*', (unsigned int)(ndx & 0xff), '\r', '\n');
+		sum += buf[2];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("checksum, sprintf():           %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		buf[0] = '*';
+		digits_put_hex2(&buf[1], (unsigned char)ndx);
+		buf[3] = '\r';
+		buf[4] = '\n';
+		sum += buf[2];
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("checksum, digits_put_hex2():   %6.1f ns/call\n", elapsed_ns(&start, &end) / ITERATIONS);
+
+	/* Print the sum, so the compiler can't optimize the loops away */
+	fprintf(stderr, "(checksum %lu)\n", sum);
+
+	return EXIT_SUCCESS;
+}
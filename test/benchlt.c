@@ -0,0 +1,120 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lt.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define ITERATIONS              1000000UL
+#define START_SECS              0x0e000000UL    /* Some time in 2007, in seconds since 2000 */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static double elapsed_ns(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+
+/* Fills in the arguments of a GPRMC sentence that lt_gprmc() looks at */
+static void make_gprmc(rtcsecs_t secs, char time[16], char date[16], char *argv[10])
+{
+	struct rtctime_t  utc;
+	unsigned char     ndx;
+
+	rtc_secs2time(secs, &utc);
+	sprintf(time, "%02u%02u%02u", utc.hour, utc.min, utc.sec);
+	sprintf(date, "%02u%02u%02u", utc.day, utc.mon + 1, utc.year % 100);
+	for (ndx = 0; ndx < 10; ndx++)
+		argv[ndx] = "";
+	argv[1] = time;
+	argv[2] = "A";
+	argv[9] = date;
+}
+
+
+/* Time taken by reading the clock around a call, to take off the results */
+static double overhead(void)
+{
+	struct timespec  start;
+	struct timespec  end;
+	double           ns = 0;
+	unsigned long    ndx;
+
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ns += elapsed_ns(&start, &end);
+	}
+
+	return ns / ITERATIONS;
+}
+
+
+/*
+ * Time lt_gprmc() on consecutive seconds, leaving out the time to make the
+ * sentences and, with predict, that of lt_predict() in between: the latency
+ * a sentence sees when the prediction was done in idle time.
+ */
+static double bench(unsigned char predict, unsigned long *sum)
+{
+	static char         time[16];
+	static char         date[16];
+	struct lt_cache_t   cache;
+	struct timespec     start;
+	struct timespec     end;
+	double              ns = 0;
+	unsigned long       ndx;
+
+	memset(&cache, 0, sizeof(cache));
+	for (ndx = 0; ndx < ITERATIONS; ndx++) {
+		char           *argv[10];
+		rtcsecs_t      utc_secs;
+		unsigned char  dst;
+
+		make_gprmc(START_SECS + ndx, time, date, argv);
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		lt_gprmc(&cache, 10, argv, &utc_secs, &dst);
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		ns += elapsed_ns(&start, &end);
+		*sum += utc_secs + time[5];
+		if (predict)
+			lt_predict(&cache);
+	}
+
+	if (predict && cache.hits != ITERATIONS - 1) {
+		fprintf(stderr, "Error: %lu of %lu predictions hit\n", cache.hits, ITERATIONS - 1);
+		exit(EXIT_FAILURE);
+	}
+
+	return ns / ITERATIONS;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	unsigned long  sum = 0;
+	double         clock_ns;
+	double         converted;
+	double         predicted;
+
+	clock_ns  = overhead();
+	converted = bench(0, &sum) - clock_ns;
+	predicted = bench(1, &sum) - clock_ns;
+	printf("lt_gprmc, converting:          %6.1f ns/call\n", converted);
+	printf("lt_gprmc, predicted:           %6.1f ns/call (%.0f%% less)\n", predicted, 100.0 * (converted - predicted) / converted);
+
+	/* Print the sum, so the compiler can't optimize the calls away */
+	fprintf(stderr, "(checksum %lu)\n", sum);
+
+	return EXIT_SUCCESS;
+}
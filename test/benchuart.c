@@ -0,0 +1,283 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <xc.h>
+
+#include "event.h"
+#include "filter.h"
+#include "uart1.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define RUN_S                   5.0     /* Virtual time per scenario */
+#define IDLE_S                  10e-6   /* Time idled per round in event_wait() */
+#define READ_LEN                8       /* Characters fetched at once, like nmea_work() */
+#define READ_CYCLES             40      /* Instruction cycles per uart1_read() call */
+#define CHAR_CYCLES             60      /* Instruction cycles to parse a character */
+#define LINE_LEN_MAX            82
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct result_t {
+	unsigned long       sentences;      /* Sentences sent */
+	unsigned long       intact;         /* Sentences read back unchanged */
+	unsigned long       unmarked;       /* Lines read back changed without a UART1_RX_LOST */
+	unsigned long       read;           /* Characters read by the main loop */
+	double              isr_max;        /* Longest interrupt in seconds */
+	struct pic_stat_t   stat;
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+/* One epoch of a typical receiver, sent once per second */
+static const char     *sentences[] = {
+	"$GPRMC,225446,A,4916.45,N,12311.12,W,000.5,054.7,191194,020.3,E*68\r\n",
+	"$GPGGA,225446,4916.45,N,12311.12,W,1,08,0.9,545.4,M,46.9,M,,*4B\r\n",
+	"$GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*39\r\n",
+	"$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75\r\n",
+	"$GPGSV,2,2,08,15,35,102,44,18,60,255,42,24,10,035,38,25,53,130,47*7A\r\n",
+	"$GPVTG,054.7,T,034.4,M,005.5,N,010.2,K*48\r\n",
+	NULL
+};
+static char           epoch[512];
+static size_t         epoch_len;
+static unsigned long  stall_cycles;         /* Main loop stall per sentence read */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void isr(void)
+{
+	if (RC1IE && RC1IF)
+		uart1_rx_isr();
+	if (TX1IE && TX1IF)
+		uart1_tx_isr();
+}
+
+
+void event_idle_hook(void)
+{
+	pic_run(IDLE_S);
+}
+
+
+static unsigned char intact(const char *line)
+{
+	unsigned char  ndx;
+
+	for (ndx = 0; sentences[ndx]; ndx++)
+		if (!strcmp(line, sentences[ndx]))
+			return 1;
+
+	return 0;
+}
+
+
+/* Sentences in the first len characters of the stream of epochs */
+static unsigned long sentences_in(unsigned long len)
+{
+	unsigned long  count = (len / epoch_len) * (sizeof(sentences) / sizeof(sentences[0]) - 1);
+	size_t         ndx;
+
+	for (ndx = 0; ndx < len % epoch_len; ndx++)
+		if (epoch[ndx] == '\n')
+			count++;
+
+	return count;
+}
+
+
+/*
+ * Run the main loop for RUN_S with a source at src_rate and the UART at
+ * uart_rate. With flow control, the GPRMC sentences are sent back out on
+ * UART1 from the tx interrupt like the firmware does, so the transmitter is
+ * busy when an Xoff is due.
+ */
+static void run(unsigned long src_rate, unsigned long uart_rate, double stall_s, unsigned char flow, struct result_t *result)
+{
+	struct pic_source_t  source = { epoch, 0, 0, 1.0, 0 };
+	char                 line[LINE_LEN_MAX + 3];
+	static char          out[LINE_LEN_MAX + 3];  /* Sent from the tx interrupt */
+#if !UART1_RX_FRAMES
+	size_t               line_len = 0;
+#endif /* UART1_RX_FRAMES */
+	double               end;
+
+	memset(result, 0, sizeof(*result));
+	source.len     = epoch_len;
+	source.bitrate = src_rate;
+	source.flow    = flow;
+	stall_cycles   = (unsigned long)(stall_s * PIC_FOSC / 4);
+
+	pic_init(isr);
+	event_init();
+	uart1_init(uart_rate, flow);
+	PEIE = 1;
+	GIE  = 1;
+	pic_source(0, &source);
+
+	for (end = pic_now() + RUN_S; pic_now() < end; ) {
+#if UART1_RX_FRAMES
+		char           *frame;
+#else
+		char           buf[READ_LEN];
+		unsigned char  ndx;
+#endif /* UART1_RX_FRAMES */
+		unsigned char  len;
+
+		event_wait();
+#if UART1_RX_FRAMES
+		/* The rx interrupt did the framing, the main loop still parses every character */
+		while ((frame = uart1_frame(0, &len)) != NULL) {
+			pic_cycles(READ_CYCLES + len * CHAR_CYCLES);
+			result->read += len + 3;
+			snprintf(line, sizeof(line), "$%s\r\n", frame);
+			if (intact(line))
+				result->intact++;
+			else if (!memchr(frame, UART1_RX_LOST, len) && len < UART1_FRAME_LEN - 1)
+				/* Changed, but neither marked nor cut off for the parser to reject */
+				result->unmarked++;
+			uart1_frame_release(frame);
+			if (flow && !strncmp(line, "$GPRMC", 6) && !uart1_sending()) {
+				strcpy(out, line);
+				uart1_send(out, (unsigned char)strlen(out));
+			}
+			pic_cycles(stall_cycles);
+		}
+#else
+		while ((len = uart1_read(buf, sizeof(buf))) != 0) {
+			pic_cycles(READ_CYCLES + len * CHAR_CYCLES);
+			result->read += len;
+			for (ndx = 0; ndx < len; ndx++) {
+				if (line_len < sizeof(line) - 1)
+					line[line_len++] = buf[ndx];
+				if (buf[ndx] != '\n')
+					continue;
+				line[line_len] = '\0';
+				if (intact(line))
+					result->intact++;
+				else if (!memchr(line, UART1_RX_LOST, line_len))
+					result->unmarked++;
+				line_len = 0;
+				if (flow && !strncmp(line, "$GPRMC", 6) && !uart1_sending()) {
+					strcpy(out, line);
+					uart1_send(out, (unsigned char)strlen(out));
+				}
+				/* Handling the sentence keeps the main loop from reading */
+				pic_cycles(stall_cycles);
+			}
+		}
+#endif /* UART1_RX_FRAMES */
+	}
+
+	uart1_term();
+	result->stat      = *pic_stat(0);
+	result->isr_max   = pic_isr_max();
+	result->sentences = sentences_in(result->stat.sent);
+}
+
+
+#if UART1_RX_FRAMES
+/* GPRMC sentences, the first of each epoch, in the first len characters of the stream of epochs */
+static unsigned long rmc_in(unsigned long len)
+{
+	return len / epoch_len + (len % epoch_len >= strlen(sentences[0]));
+}
+#endif /* UART1_RX_FRAMES */
+
+
+static double percent(unsigned long part, unsigned long whole)
+{
+	return whole ? 100.0 * part / whole : 0.0;
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	static const unsigned long  rates[] = { 4800, 9600, 19200, 38400, 115200, 0 };
+	static const double         stalls_ms[] = { 0, 1, 5, 20, -1 };
+	static const int            mismatch[] = { -6, -5, -4, -3, -2, -1, 0, 1, 2, 3, 4, 5, 6, 100 };
+	struct result_t             result;
+	unsigned char               ndx;
+	unsigned char               stall;
+
+	for (ndx = 0; sentences[ndx]; ndx++) {
+		strcpy(&epoch[epoch_len], sentences[ndx]);
+		epoch_len += strlen(sentences[ndx]);
+	}
+
+	/* Sanity check of the emulation: nothing may be lost without stalls */
+	run(4800, 4800, 0, 0, &result);
+	if (result.intact != result.sentences || result.stat.overruns || result.stat.framing) {
+		fprintf(stderr, "Error: %lu of %lu sentences intact without stalls\n", result.intact, result.sentences);
+		return EXIT_FAILURE;
+	}
+
+#if UART1_RX_FRAMES
+	printf("Receive pool of %u sentences, %zu characters per epoch\n", UART1_RX_FRAMES, epoch_len);
+#else
+	printf("Receive buffer of %u characters, %zu characters per epoch\n", BUFFER_SIZE, epoch_len);
+#endif /* UART1_RX_FRAMES */
+	printf("Sentences intact (characters lost) for a stall per sentence of:\n");
+	printf("bit rate");
+	for (stall = 0; stalls_ms[stall] >= 0; stall++)
+		printf("  %8.0f ms      ", stalls_ms[stall]);
+	printf("\n");
+	for (ndx = 0; rates[ndx]; ndx++) {
+		printf("%8lu", rates[ndx]);
+		for (stall = 0; stalls_ms[stall] >= 0; stall++) {
+			run(rates[ndx], rates[ndx], stalls_ms[stall] / 1000, 0, &result);
+			if (result.unmarked) {
+				fprintf(stderr, "\nError: %lu lines changed without notice at %lu bit/s\n", result.unmarked, rates[ndx]);
+				return EXIT_FAILURE;
+			}
+			printf("  %5.1f%% (%5.1f%%)", percent(result.intact, result.sentences),
+			       percent(result.stat.sent - result.read, result.stat.sent));
+		}
+		printf("\n");
+	}
+
+	printf("\nSource bit rate off from 9600, no stalls:\n");
+	printf("  offset  intact  framing errors  overruns\n");
+	for (ndx = 0; mismatch[ndx] != 100; ndx++) {
+		run(9600 * (100 + mismatch[ndx]) / 100, 9600, 0, 0, &result);
+		printf("  %+5d%%  %5.1f%%  %14lu  %8lu\n", mismatch[ndx], percent(result.intact, result.sentences),
+		       result.stat.framing, result.stat.overruns);
+	}
+
+	printf("\nXon/Xoff at 115200, intact (characters lost), Xoffs obeyed and longest interrupt:\n");
+	printf("   stall  without                       with\n");
+	for (stall = 0; stalls_ms[stall] >= 0; stall++) {
+		struct result_t  with;
+
+		run(115200, 115200, stalls_ms[stall] / 1000, 0, &result);
+		run(115200, 115200, stalls_ms[stall] / 1000, 1, &with);
+		printf("%5.0f ms  %5.1f%% (%5.1f%%) %5.1f us  %5.1f%% (%5.1f%%) %5lu %5.1f us\n", stalls_ms[stall],
+		       percent(result.intact, result.sentences), percent(result.stat.sent - result.read, result.stat.sent), result.isr_max * 1e6,
+		       percent(with.intact, with.sentences), percent(with.stat.sent - with.read, with.stat.sent), with.stat.xoffs, with.isr_max * 1e6);
+	}
+
+#if UART1_RX_FRAMES
+	/* The rest is dropped after the address field, so only GPRMC costs the main loop a stall */
+	printf("\nOnly GPRMC let through by the rx interrupt at 115200, GPRMC intact:\n");
+	printf("   stall  intact\n");
+	filter_set(FILTER_DROP, FILTER_TALKERS_DEFAULT, 0x01);
+	for (stall = 0; stalls_ms[stall] >= 0; stall++) {
+		run(115200, 115200, stalls_ms[stall] / 1000, 0, &result);
+		printf("%5.0f ms  %5.1f%%\n", stalls_ms[stall], percent(result.intact, rmc_in(result.stat.sent)));
+	}
+	filter_set(FILTER_OFF, FILTER_TALKERS_DEFAULT, FILTER_TYPES_DEFAULT);
+#endif /* UART1_RX_FRAMES */
+
+	return EXIT_SUCCESS;
+}
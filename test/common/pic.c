@@ -0,0 +1,615 @@
+/******************************************************************************/
+/* File    : pic.c                                                            */
+/* Function: Host emulation of the PIC16F15325 peripherals used by the drivers*/
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Emulates the EUSARTs, timer 0, timer 1 and the oscillator tuning against  */
+/* a virtual clock, so the drivers can run on the host unchanged. A source   */
+/* attached to an EUSART drives its receive line bit by bit at its own bit   */
+/* rate, and the receiver samples that line at the rate set by the bit rate  */
+/* generator, so bit rate mismatches show up as garbled characters and       */
+/* framing errors like they do on the real thing. The receive FIFO is two    */
+/* deep, a third character sets OERR and stops the receiver until CREN is    */
+/* cleared.                                                                   */
+/*                                                                            */
+/* Virtual time only passes when the test says so: pic_run() for idling,     */
+/* pic_cycles() for code that is being modelled, and a few cycles for every  */
+/* poll of an interrupt flag, so busy-waits end. Interrupts are taken while  */
+/* time passes, each costing PIC_ISR_CYCLES on top of the handler.           */
+/******************************************************************************/
+#include <math.h>
+#include <string.h>
+
+#include "pic.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define FRAME_BITS              10      /* Start bit, 8 data bits, stop bit */
+#define FRAMES                  8       /* Frames of a source kept for sampling */
+#define NEVER                   HUGE_VAL
+
+#define XON                     0x11
+#define XOFF                    0x13
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct frame_t {
+	double                start;
+	unsigned char         ch;
+};
+
+struct eusart_t {
+	struct pic_eusart_t   regs;
+
+	/* Receiver */
+	unsigned char         fifo[PIC_FIFO_DEPTH];
+	unsigned char         fifo_ferr[PIC_FIFO_DEPTH];
+	unsigned char         fifo_used;
+	unsigned char         rx_on;        /* CREN and SPEN, as last seen */
+	double                rx_from;      /* Time from which to look for a start bit */
+	double                rx_edge;      /* Start of the character being received */
+
+	/* Transmitter */
+	unsigned char         txreg_full;
+	unsigned char         tsr;
+	unsigned char         tsr_busy;
+	double                tsr_done;
+
+	/* Source */
+	struct pic_source_t   source;
+	struct frame_t        frame[FRAMES];
+	unsigned long         frames;       /* Frames sent, the last FRAMES of which are kept */
+	size_t                pos;
+	double                burst_start;
+	double                line_free;    /* Earliest start of the next frame */
+	unsigned char         paused;
+	double                pause_at;     /* No frame starts from here while paused */
+
+	struct pic_stat_t     stat;
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static struct eusart_t    eusart[PIC_EUSARTS];
+static struct pic_core_t  core;
+static void               (*isr)(void);
+static unsigned char      in_isr;
+static double             isr_max;      /* Longest time spent in an interrupt */
+static double             now;
+static double             cycles;       /* Instruction cycles since start, for TMR1 */
+static double             osc_error;
+static unsigned char      tmr0_on;
+static unsigned char      tmr0_restart;
+static double             tmr0_next;
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void advance(double to);
+
+
+static double fosc(void)
+{
+	int  tune = core.osctune.HFTUN;
+
+	if (tune & 0x20)
+		tune -= 0x40;
+
+	return PIC_FOSC * (1.0 + osc_error + tune * PIC_HFTUN_STEP);
+}
+
+
+static void set_now(double t)
+{
+	if (t <= now)
+		return;
+	cycles += (t - now) * fosc() / 4;
+	now     = t;
+}
+
+
+/* Bit time of the EUSART's bit rate generator */
+static double bit_time(const struct eusart_t *e)
+{
+	unsigned int  brg = e->regs.spbrgl;
+	unsigned int  mult;
+
+	if (e->regs.baudcon.BRG16)
+		brg |= (unsigned int)e->regs.spbrgh << 8;
+	if (e->regs.txsta.BRGH)
+		mult = e->regs.baudcon.BRG16 ? 4 : 16;
+	else
+		mult = e->regs.baudcon.BRG16 ? 16 : 64;
+
+	return mult * (brg + 1.0) / fosc();
+}
+
+
+static double source_bit_time(const struct eusart_t *e)
+{
+	return 1.0 / e->source.bitrate;
+}
+
+
+static unsigned char frame_bit(const struct frame_t *f, int bit)
+{
+	if (bit == 0)
+		return 0;
+	if (bit <= 8)
+		return (f->ch >> (bit - 1)) & 1;
+
+	return 1;
+}
+
+
+static double next_start(const struct eusart_t *e)
+{
+	double  t = e->line_free;
+
+	if (!e->source.len)
+		return NEVER;
+	if (e->source.period > 0 && e->pos == 0 && t < e->burst_start)
+		t = e->burst_start;
+	if (e->paused && t >= e->pause_at)
+		return NEVER;
+
+	return t;
+}
+
+
+/* Let the source start all frames it would have started by time t */
+static void generate_until(struct eusart_t *e, double t)
+{
+	double  start;
+
+	while ((start = next_start(e)) <= t) {
+		struct frame_t  *f = &e->frame[e->frames++ % FRAMES];
+
+		f->start     = start;
+		f->ch        = e->source.data[e->pos];
+		e->line_free = start + FRAME_BITS * source_bit_time(e);
+		e->stat.sent++;
+		if (++e->pos >= e->source.len) {
+			e->pos = 0;
+			e->burst_start += e->source.period;
+		}
+	}
+}
+
+
+/* Level of the receive line at time t */
+static unsigned char level(struct eusart_t *e, double t)
+{
+	unsigned long  n;
+
+	generate_until(e, t);
+	for (n = 0; n < FRAMES && n < e->frames; n++) {
+		const struct frame_t  *f = &e->frame[(e->frames - 1 - n) % FRAMES];
+		int                   bit;
+
+		if (f->start > t)
+			continue;
+		bit = (int)floor((t - f->start) / source_bit_time(e));
+		return frame_bit(f, bit);
+	}
+
+	return 1;   /* Idle */
+}
+
+
+/* First falling edge of the receive line at or after time 'from' */
+static double next_edge(struct eusart_t *e, double from)
+{
+	double         later = NEVER;
+	unsigned long  n;
+
+	generate_until(e, from);
+	for (n = 0; n < FRAMES && n < e->frames; n++) {
+		const struct frame_t  *f = &e->frame[(e->frames - 1 - n) % FRAMES];
+		int                   bit;
+
+		if (f->start > from) {
+			later = f->start;
+			continue;
+		}
+		/* The frame on the line at 'from', the line is high before its start bit */
+		for (bit = 0; bit < FRAME_BITS; bit++) {
+			double  t = f->start + bit * source_bit_time(e);
+
+			if (t >= from && !frame_bit(f, bit) && (bit == 0 || frame_bit(f, bit - 1)))
+				return t;
+		}
+		break;
+	}
+	if (later != NEVER)
+		return later;
+
+	return next_start(e);
+}
+
+
+/* Time the receiver samples the stop bit of the next character, NEVER if there is none */
+static double rx_next(struct eusart_t *e)
+{
+	double  t_rx;
+	double  edge;
+
+	if (!e->rx_on || e->regs.rcsta.OERR || !e->source.len)
+		return NEVER;
+
+	t_rx = bit_time(e);
+	for (;;) {
+		if ((edge = next_edge(e, e->rx_from)) == NEVER)
+			return NEVER;
+		/* Check the start bit halfway, like the receiver does */
+		if (!level(e, edge + t_rx / 2))
+			break;
+		e->rx_from = edge + t_rx / 2;
+	}
+	e->rx_edge = edge;
+
+	return edge + (FRAME_BITS - 0.5) * t_rx;
+}
+
+
+static void rx_done(struct eusart_t *e, double done)
+{
+	double         t_rx = bit_time(e);
+	unsigned char  ch = 0;
+	unsigned char  stop;
+	int            bit;
+
+	for (bit = 0; bit < 8; bit++)
+		if (level(e, e->rx_edge + (bit + 1.5) * t_rx))
+			ch |= 1 << bit;
+	stop       = level(e, done);
+	e->rx_from = done;
+
+	if (e->fifo_used >= PIC_FIFO_DEPTH) {
+		e->regs.rcsta.OERR = 1;
+		e->stat.overruns++;
+		return;
+	}
+	e->fifo[e->fifo_used]      = ch;
+	e->fifo_ferr[e->fifo_used] = !stop;
+	e->fifo_used++;
+	e->regs.rcsta.FERR = e->fifo_ferr[0];
+	e->stat.received++;
+	if (!stop)
+		e->stat.framing++;
+}
+
+
+static void tx_start(struct eusart_t *e, double t)
+{
+	e->tsr        = e->regs.txreg;
+	e->tsr_busy   = 1;
+	e->tsr_done   = t + FRAME_BITS * bit_time(e);
+	e->txreg_full = 0;
+}
+
+
+static void tx_done(struct eusart_t *e)
+{
+	e->tsr_busy = 0;
+	e->stat.transmitted++;
+
+	/* The source reacts to Xon/Xoff after finishing the frame it is sending */
+	if (e->source.flow && e->source.len) {
+		double  reaction = FRAME_BITS * source_bit_time(e);
+
+		if (e->tsr == XOFF && !e->paused) {
+			e->paused   = 1;
+			e->pause_at = e->tsr_done + reaction;
+			e->stat.xoffs++;
+		} else if (e->tsr == XON && e->paused) {
+			e->paused = 0;
+			if (e->line_free >= e->pause_at && e->line_free < e->tsr_done + reaction)
+				e->line_free = e->tsr_done + reaction;
+		}
+	}
+
+	if (e->txreg_full && e->regs.txsta.TXEN && e->regs.rcsta.SPEN)
+		tx_start(e, e->tsr_done);
+}
+
+
+/* Act on what the code wrote to the registers of an EUSART since the last access */
+static void sync_eusart(struct eusart_t *e)
+{
+	/* Receiver: clearing CREN resets it and clears OERR */
+	if (!e->regs.rcsta.CREN || !e->regs.rcsta.SPEN) {
+		e->rx_on           = 0;
+		e->regs.rcsta.OERR = 0;
+	} else if (!e->rx_on) {
+		e->rx_on   = 1;
+		e->rx_from = now;
+	}
+
+	/* Transmitter: clearing TXEN resets it, aborting the character being sent */
+	if (!e->regs.txsta.TXEN || !e->regs.rcsta.SPEN) {
+		if (e->tsr_busy)
+			e->stat.aborted++;
+		e->tsr_busy   = 0;
+		e->txreg_full = 0;
+	} else if (e->txreg_full && !e->tsr_busy)
+		tx_start(e, now);
+	e->regs.txsta.TRMT = !e->tsr_busy;
+}
+
+
+static double tmr0_period(void)
+{
+	double  clock = (core.t0con1.T0CS == 3) ? fosc() : fosc() / 4;
+	double  counts = core.t0con0.T016BIT ? 65536.0 : core.tmr0h + 1.0;
+
+	return (1UL << core.t0con1.T0CKPS) * counts * (core.t0con0.T0OUTPS + 1) / clock;
+}
+
+
+static void sync_core(void)
+{
+	/* Only the HFINTOSC and Fosc/4 clock sources are emulated */
+	unsigned char  on = core.t0con0.T0EN && (core.t0con1.T0CS == 2 || core.t0con1.T0CS == 3);
+
+	if (on && (!tmr0_on || tmr0_restart))
+		tmr0_next = now + tmr0_period();
+	tmr0_on      = on;
+	tmr0_restart = 0;
+	core.tmr1    = (unsigned int)fmod(cycles, 65536.0);
+}
+
+
+static void sync_all(void)
+{
+	unsigned char  n;
+
+	sync_core();
+	for (n = 0; n < PIC_EUSARTS; n++)
+		sync_eusart(&eusart[n]);
+}
+
+
+static unsigned char interrupt_pending(void)
+{
+	unsigned char  n;
+
+	if (!core.gie)
+		return 0;
+	if (core.tmr0ie && core.tmr0if)
+		return 1;
+	if (!core.peie)
+		return 0;
+	for (n = 0; n < PIC_EUSARTS; n++) {
+		if (eusart[n].regs.rcie && eusart[n].fifo_used)
+			return 1;
+		if (eusart[n].regs.txie && !eusart[n].txreg_full)
+			return 1;
+	}
+
+	return 0;
+}
+
+
+static void interrupt(void)
+{
+	double  start = now;
+
+	in_isr = 1;
+	isr();
+	advance(now + PIC_ISR_CYCLES * 4 / fosc());
+	in_isr = 0;
+	if (now - start > isr_max)
+		isr_max = now - start;
+}
+
+
+/* Let virtual time pass until 'to', taking interrupts on the way */
+static void advance(double to)
+{
+	for (;;) {
+		struct eusart_t  *rx = NULL;
+		struct eusart_t  *tx = NULL;
+		unsigned char    tick = 0;
+		double           next = to;
+		unsigned char    n;
+
+		sync_all();
+		if (now < to && !in_isr && isr && interrupt_pending()) {
+			interrupt();
+			continue;
+		}
+
+		for (n = 0; n < PIC_EUSARTS; n++) {
+			struct eusart_t  *e = &eusart[n];
+			double           t = rx_next(e);
+
+			if (t <= next) {
+				next = t;
+				rx   = e;
+				tx   = NULL;
+				tick = 0;
+			}
+			if (e->tsr_busy && e->tsr_done <= next) {
+				next = e->tsr_done;
+				rx   = NULL;
+				tx   = e;
+				tick = 0;
+			}
+		}
+		if (tmr0_on && tmr0_next <= next) {
+			next = tmr0_next;
+			rx   = NULL;
+			tx   = NULL;
+			tick = 1;
+		}
+
+		set_now(next);
+		if (rx)
+			rx_done(rx, next);
+		else if (tx)
+			tx_done(tx);
+		else if (tick) {
+			core.tmr0if = 1;
+			tmr0_next  += tmr0_period();
+		} else
+			return;
+	}
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void pic_init(void (*handler)(void))
+{
+	memset(eusart, 0, sizeof(eusart));
+	memset(&core, 0, sizeof(core));
+	isr          = handler;
+	in_isr       = 0;
+	isr_max      = 0;
+	now          = 0;
+	cycles       = 0;
+	osc_error    = 0;
+	tmr0_on      = 0;
+	tmr0_restart = 0;
+}
+
+
+/* Set the relative error of the oscillator at OSCTUNE.HFTUN 0 */
+void pic_osc_error(double error)
+{
+	osc_error = error;
+}
+
+
+/* Attach a source to the receive line of an EUSART, it starts sending right away */
+void pic_source(unsigned char n, const struct pic_source_t *source)
+{
+	struct eusart_t  *e = &eusart[n];
+
+	e->source      = *source;
+	e->frames      = 0;
+	e->pos         = 0;
+	e->burst_start = now;
+	e->line_free   = now;
+	e->paused      = 0;
+	e->rx_from     = now;
+}
+
+
+/* Idle, or do anything else that is not modelled, for a number of seconds */
+void pic_run(double seconds)
+{
+	advance(now + seconds);
+}
+
+
+/* Execute code that takes a number of instruction cycles */
+void pic_cycles(unsigned long count)
+{
+	advance(now + count * 4 / fosc());
+}
+
+
+double pic_now(void)
+{
+	return now;
+}
+
+
+const struct pic_stat_t *pic_stat(unsigned char n)
+{
+	generate_until(&eusart[n], now);
+
+	return &eusart[n].stat;
+}
+
+
+double pic_isr_max(void)
+{
+	return isr_max;
+}
+
+
+struct pic_eusart_t *pic_eusart(unsigned char n)
+{
+	sync_eusart(&eusart[n]);
+
+	return &eusart[n].regs;
+}
+
+
+/* Read RCxREG, popping the receive FIFO */
+unsigned char pic_rcreg(unsigned char n)
+{
+	struct eusart_t  *e = &eusart[n];
+	unsigned char    ch;
+
+	sync_eusart(e);
+	if (!e->fifo_used)
+		return e->fifo[0];
+	ch = e->fifo[0];
+	e->fifo_used--;
+	memmove(&e->fifo[0], &e->fifo[1], e->fifo_used);
+	memmove(&e->fifo_ferr[0], &e->fifo_ferr[1], e->fifo_used);
+	e->regs.rcsta.FERR = e->fifo_used ? e->fifo_ferr[0] : 0;
+
+	return ch;
+}
+
+
+/* Write TXxREG: the character is taken over on the next access or when time passes */
+unsigned char *pic_txreg(unsigned char n)
+{
+	struct eusart_t  *e = &eusart[n];
+
+	sync_eusart(e);
+	e->txreg_full = 1;
+
+	return &e->regs.txreg;
+}
+
+
+unsigned char pic_rcif(unsigned char n)
+{
+	pic_cycles(PIC_POLL_CYCLES);
+	sync_eusart(&eusart[n]);
+
+	return eusart[n].fifo_used != 0;
+}
+
+
+unsigned char pic_txif(unsigned char n)
+{
+	pic_cycles(PIC_POLL_CYCLES);
+	sync_eusart(&eusart[n]);
+
+	return !eusart[n].txreg_full;
+}
+
+
+struct pic_core_t *pic_core(void)
+{
+	sync_core();
+
+	return &core;
+}
+
+
+/* Write TMR0L, which restarts the timer 0 period */
+unsigned char *pic_tmr0l(void)
+{
+	sync_core();
+	tmr0_restart = 1;
+
+	return &core.tmr0l;
+}
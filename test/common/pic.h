@@ -0,0 +1,151 @@
+/******************************************************************************/
+/* File    : pic.h                                                            */
+/* Function: Header file of 'pic.c'                                           */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/******************************************************************************/
+#ifndef PIC_H
+#define PIC_H
+
+#include <stddef.h>
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define PIC_FOSC                32000000UL  /* Nominal HFINTOSC frequency */
+#define PIC_EUSARTS             2
+#define PIC_FIFO_DEPTH          2           /* Receive FIFO depth of the EUSART */
+#define PIC_HFTUN_STEP          0.001       /* Approximate relative frequency change per OSCTUNE.HFTUN step */
+#define PIC_POLL_CYCLES         3           /* Instruction cycles taken by polling an interrupt flag */
+#define PIC_ISR_CYCLES          40          /* Instruction cycles of interrupt entry, context saving and exit */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+/* Register bit fields, bit 0 first */
+struct pic_rcsta_t {
+	unsigned  RX9D    : 1;
+	unsigned  OERR    : 1;
+	unsigned  FERR    : 1;
+	unsigned  ADDEN   : 1;
+	unsigned  CREN    : 1;
+	unsigned  SREN    : 1;
+	unsigned  RX9     : 1;
+	unsigned  SPEN    : 1;
+};
+
+struct pic_txsta_t {
+	unsigned  TX9D    : 1;
+	unsigned  TRMT    : 1;
+	unsigned  BRGH    : 1;
+	unsigned  SENDB   : 1;
+	unsigned  SYNC    : 1;
+	unsigned  TXEN    : 1;
+	unsigned  TX9     : 1;
+	unsigned  CSRC    : 1;
+};
+
+struct pic_baudcon_t {
+	unsigned  ABDEN   : 1;
+	unsigned  WUE     : 1;
+	unsigned          : 1;
+	unsigned  BRG16   : 1;
+	unsigned  SCKP    : 1;
+	unsigned          : 1;
+	unsigned  RCIDL   : 1;
+	unsigned  ABDOVF  : 1;
+};
+
+struct pic_t0con0_t {
+	unsigned  T0OUTPS : 4;
+	unsigned  T016BIT : 1;
+	unsigned          : 1;
+	unsigned  T0OUT   : 1;
+	unsigned  T0EN    : 1;
+};
+
+struct pic_t0con1_t {
+	unsigned  T0CKPS  : 4;
+	unsigned  T0ASYNC : 1;
+	unsigned  T0CS    : 3;
+};
+
+struct pic_osctune_t {
+	unsigned  HFTUN   : 6;
+	unsigned          : 2;
+};
+
+/* The registers of one EUSART the code reads and writes directly */
+struct pic_eusart_t {
+	struct pic_rcsta_t    rcsta;
+	struct pic_txsta_t    txsta;
+	struct pic_baudcon_t  baudcon;
+	unsigned char         spbrgl;
+	unsigned char         spbrgh;
+	unsigned char         txreg;        /* Latch, taken over by the transmitter on the next access */
+	unsigned char         rcie;
+	unsigned char         txie;
+};
+
+/* The core, oscillator and timer registers the code reads and writes directly */
+struct pic_core_t {
+	unsigned char         gie;
+	unsigned char         peie;
+	unsigned char         tmr0ie;
+	unsigned char         tmr0if;
+	unsigned char         tmr0l;        /* Writing it restarts the timer 0 period */
+	unsigned char         tmr0h;
+	struct pic_t0con0_t   t0con0;
+	struct pic_t0con1_t   t0con1;
+	struct pic_osctune_t  osctune;
+	unsigned int          tmr1;         /* Free-running at Fosc/4, writes are ignored */
+};
+
+/* A device transmitting into an EUSART */
+struct pic_source_t {
+	const char            *data;        /* Sent over and over again */
+	size_t                len;
+	unsigned long         bitrate;
+	double                period;       /* Start of each burst of len characters in seconds, 0 to send back to back */
+	unsigned char         flow;         /* Obey Xon/Xoff transmitted by the EUSART */
+};
+
+struct pic_stat_t {
+	unsigned long         sent;         /* Characters sent by the source */
+	unsigned long         received;     /* Characters put in the receive FIFO */
+	unsigned long         framing;      /* Of which with a framing error */
+	unsigned long         overruns;     /* Characters lost to a full receive FIFO */
+	unsigned long         transmitted;  /* Characters transmitted completely */
+	unsigned long         aborted;      /* Characters cut off by clearing TXEN */
+	unsigned long         xoffs;        /* Xoffs obeyed by the source */
+	unsigned long         interrupts;   /* Interrupts taken, for all sources */
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+/* Emulation control */
+void                      pic_init      (void (*isr)(void));
+void                      pic_osc_error (double error);
+void                      pic_source    (unsigned char eusart,
+                                         const struct pic_source_t *source);
+void                      pic_run       (double seconds);
+void                      pic_cycles    (unsigned long cycles);
+double                    pic_now       (void);
+const struct pic_stat_t  *pic_stat      (unsigned char eusart);
+double                    pic_isr_max   (void);
+
+/* Register access, through the macros in xc.h */
+struct pic_eusart_t      *pic_eusart    (unsigned char eusart);
+unsigned char             pic_rcreg     (unsigned char eusart);
+unsigned char            *pic_txreg     (unsigned char eusart);
+unsigned char             pic_rcif      (unsigned char eusart);
+unsigned char             pic_txif      (unsigned char eusart);
+struct pic_core_t        *pic_core      (void);
+unsigned char            *pic_tmr0l     (void);
+
+
+#endif /* PIC_H */
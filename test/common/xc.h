@@ -0,0 +1,69 @@
+/******************************************************************************/
+/* File    : xc.h                                                             */
+/* Function: Host stand-in for the XC8 device header                          */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Maps the PIC16F15325 registers used by the drivers onto the emulator in    */
+/* 'pic.c', so the drivers compile for the host unchanged. Registers with     */
+/* side effects (RCxREG, TXxREG, the interrupt flags, TMR0L) go through       */
+/* accessors, the others through a pointer that brings the emulated          */
+/* peripheral up to date with earlier writes first.                           */
+/******************************************************************************/
+#ifndef XC_H
+#define XC_H
+
+#include "pic.h"
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define __interrupt()
+#define CLRWDT()                ((void)0)
+#define NOP()                   ((void)0)
+
+/* Core */
+#define GIE                     (pic_core()->gie)
+#define PEIE                    (pic_core()->peie)
+#define OSCTUNEbits             (pic_core()->osctune)
+
+/* Timer 0 and 1 */
+#define TMR0IE                  (pic_core()->tmr0ie)
+#define TMR0IF                  (pic_core()->tmr0if)
+#define TMR0L                   (*pic_tmr0l())
+#define TMR0H                   (pic_core()->tmr0h)
+#define T0CON0bits              (pic_core()->t0con0)
+#define T0CON1bits              (pic_core()->t0con1)
+#define TMR1                    (pic_core()->tmr1)
+
+/* EUSART 1 */
+#define RC1STAbits              (pic_eusart(0)->rcsta)
+#define TX1STAbits              (pic_eusart(0)->txsta)
+#define BAUD1CONbits            (pic_eusart(0)->baudcon)
+#define SP1BRGL                 (pic_eusart(0)->spbrgl)
+#define SP1BRGH                 (pic_eusart(0)->spbrgh)
+#define RC1REG                  (pic_rcreg(0))
+#define TX1REG                  (*pic_txreg(0))
+#define RC1IE                   (pic_eusart(0)->rcie)
+#define TX1IE                   (pic_eusart(0)->txie)
+#define RC1IF                   (pic_rcif(0))
+#define TX1IF                   (pic_txif(0))
+#define RCIF                    RC1IF
+#define TXIF                    TX1IF
+
+/* EUSART 2 */
+#define RC2STAbits              (pic_eusart(1)->rcsta)
+#define TX2STAbits              (pic_eusart(1)->txsta)
+#define BAUD2CONbits            (pic_eusart(1)->baudcon)
+#define SP2BRGL                 (pic_eusart(1)->spbrgl)
+#define SP2BRGH                 (pic_eusart(1)->spbrgh)
+#define RC2REG                  (pic_rcreg(1))
+#define TX2REG                  (*pic_txreg(1))
+#define RC2IE                   (pic_eusart(1)->rcie)
+#define TX2IE                   (pic_eusart(1)->txie)
+#define RC2IF                   (pic_rcif(1))
+#define TX2IF                   (pic_txif(1))
+
+
+#endif /* XC_H */
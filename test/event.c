@@ -0,0 +1 @@
+../event.c
\ No newline at end of file
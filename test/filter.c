@@ -0,0 +1 @@
+../filter.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lt.c
\ No newline at end of file
@@ -0,0 +1 @@
+../lt.h
\ No newline at end of file
@@ -0,0 +1 @@
+../nmea.c
\ No newline at end of file
@@ -0,0 +1 @@
+../nmea.h
\ No newline at end of file
@@ -0,0 +1 @@
+../nmeactx.c
\ No newline at end of file
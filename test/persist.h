@@ -0,0 +1 @@
+../persist.h
\ No newline at end of file
@@ -0,0 +1 @@
+../sched.c
\ No newline at end of file
@@ -0,0 +1 @@
+../sched.h
\ No newline at end of file
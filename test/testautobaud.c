@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "uart1.h"
+#include "nmea.h"
+#include "autobaud.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define SENTENCE_LEN            70      /* Characters per sentence of the modelled source */
+#define SECONDS_MAX             60      /* Time allowed for a (re)lock */
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static unsigned long  source_rate;          /* Bit rate of the modelled source */
+static unsigned long  uart_rate;            /* Bit rate the UART was set to */
+static unsigned int   rx_count;
+static unsigned int   rx_errors;
+static unsigned char  valid;
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+/*
+ * One second of a source sending one sentence per second. At the right rate
+ * the sentence arrives intact; at a wrong rate the UART turns it into a few
+ * characters and framing errors, depending on the rate mismatch.
+ */
+static void second(void)
+{
+	unsigned char  chunk;
+
+	for (chunk = 0; chunk < SENTENCE_LEN / 10; chunk++) {
+		if (uart_rate == source_rate) {
+			rx_count += 10;
+		} else if (uart_rate < source_rate) {
+			rx_count  += 2;
+			rx_errors += 1;
+		} else {
+			rx_count  += 10;
+			rx_errors += 3;
+		}
+		autobaud_work();
+	}
+	if (uart_rate == source_rate)
+		valid++;
+	autobaud_work();
+}
+
+
+static unsigned int lock(const char *test)
+{
+	unsigned int  seconds;
+
+	for (seconds = 1; seconds <= SECONDS_MAX; seconds++) {
+		second();
+		if (autobaud_locked() && autobaud_bitrate() == source_rate) {
+			printf("%s: locked at %lu bit/s after %u s\n", test, source_rate, seconds);
+			return seconds;
+		}
+	}
+	fprintf(stderr, "Error: %s did not lock at %lu bit/s, at %lu bit/s\n", test, source_rate, autobaud_bitrate());
+	exit(EXIT_FAILURE);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void uart1_set_bitrate(unsigned long bitrate)
+{
+	uart_rate = bitrate;
+}
+
+
+unsigned int uart1_rx_count(void)
+{
+	return rx_count;
+}
+
+
+unsigned int uart1_rx_errors(void)
+{
+	return rx_errors;
+}
+
+
+unsigned char nmea_valid(void)
+{
+	return valid;
+}
+
+
+int main(int argc, char* argv[])
+{
+	unsigned int  seconds;
+
+	/* Configured rate matches the source */
+	source_rate = uart_rate = NMEA_IN_BITRATE;
+	autobaud_init(uart_rate);
+	lock("matching");
+
+	/* Staying locked without errors */
+	for (seconds = 0; seconds < SECONDS_MAX; seconds++)
+		second();
+	if (!autobaud_locked() || uart_rate != source_rate) {
+		fprintf(stderr, "Error: lost lock on a clean source\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* A silent source keeps the rate */
+	for (seconds = 0; seconds < SECONDS_MAX; seconds++)
+		autobaud_work();
+	if (!autobaud_locked() || autobaud_bitrate() != source_rate) {
+		fprintf(stderr, "Error: lost lock on a silent source\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Source changes to a higher and a lower rate */
+	source_rate = 38400;
+	lock("faster");
+	source_rate = 9600;
+	lock("slower");
+	source_rate = 115200;
+	lock("fastest");
+	source_rate = 4800;
+	lock("slowest");
+
+	/* A burst of garbage longer than a byte counter can hold, seen in a single late run */
+	source_rate = 9600;
+	rx_count += AUTOBAUD_LOSS_EVENTS;
+	autobaud_work();
+	if (autobaud_locked() || uart_rate == 4800) {
+		fprintf(stderr, "Error: missed %u characters between two runs\n", AUTOBAUD_LOSS_EVENTS);
+		exit(EXIT_FAILURE);
+	}
+	lock("late");
+
+	fprintf(stderr, "Test completed successfully\n");
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,84 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "event.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define ARRAY_SIZE(x)           (sizeof(x) / sizeof((x)[0]))
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static const unsigned char  *script;      /* Events 'raised by interrupts' while idling, one per idle */
+static unsigned int         script_len;
+static unsigned int         idles;        /* Number of times the model idled */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void reset(const unsigned char *events, unsigned int len)
+{
+	event_init();
+	script     = events;
+	script_len = len;
+	idles      = 0;
+}
+
+
+static void expect(const char *test, unsigned char events, unsigned char expected_events, unsigned int expected_idles)
+{
+	if (events != expected_events || idles != expected_idles) {
+		fprintf(stderr, "Error: %s produced events 0x%02x after %u idles, expected 0x%02x after %u idles\n",
+		        test, events, idles, expected_events, expected_idles);
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/* Model of the idle state: the next scripted interrupt wakes the CPU up */
+void event_idle_hook(void)
+{
+	idles++;
+	if (!script_len) {
+		fprintf(stderr, "Error: idling without any interrupt left to wake up\n");
+		exit(EXIT_FAILURE);
+	}
+	event_post(*script++);
+	script_len--;
+}
+
+
+int main(int argc, char* argv[])
+{
+	static const unsigned char  two[] = { EVENT_UART2_RX, EVENT_UART1_EOL };
+
+	/* Events pending before waiting are returned without idling */
+	reset(NULL, 0);
+	event_post(EVENT_UART2_RX);
+	expect("pending event", event_wait(), EVENT_UART2_RX, 0);
+
+	/* Waiting idles until an interrupt posts an event, one wake-up per wait */
+	reset(two, ARRAY_SIZE(two));
+	expect("first wake-up", event_wait(), EVENT_UART2_RX, 1);
+	expect("second wake-up", event_wait(), EVENT_UART1_EOL, 2);
+
+	/* Several posts before fetching coalesce, and fetching clears them */
+	reset(NULL, 0);
+	event_post(EVENT_UART1_RX);
+	event_post(EVENT_UART1_EOL);
+	event_post(EVENT_UART1_RX);
+	expect("coalescing", event_wait(), EVENT_UART1_RX | EVENT_UART1_EOL, 0);
+	expect("cleared", event_get(), 0, 0);
+
+	fprintf(stderr, "Test completed successfully\n");
+
+	return EXIT_SUCCESS;
+}
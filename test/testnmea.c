@@ -0,0 +1,446 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "nmeactx.h"
+#include "filter.h"
+#include "lt.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define STREAMS                 2
+#define OUT_LEN                 256
+#define PREDICT_STEPS           20      /* Seconds converted per run of test_predict() */
+
+
+/******************************************************************************/
+/* Types                                                                      */
+/******************************************************************************/
+struct stream_t {
+	struct nmea_ctx_t  ctx;
+	struct lt_cache_t  cache;
+	char               out[OUT_LEN];    /* Converted sentences, concatenated */
+};
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static void handle_gpgga(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static void handle_gpzda(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+static const struct nmea_t  nmea[] = {
+	{"GPRMC", handle_gprmc},
+	{"GPGGA", handle_gpgga},
+	{"GPZDA", handle_gpzda},
+	{NULL,    NULL}
+};
+
+static const char  *in[STREAMS] = {
+	/* Winter time across new year, with some noise and a bad checksum */
+	"xx$GPRMC,235959,A,5213.0,N,00600.0,E,0.0,0.0,311217,003.1,W*63\r\n"
+	"$GPZDA,235959,31,12,2017,00,00*4C\r\n"
+	"$GPGGA,235959,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*7A\r\n"
+	"$GPRMC,000000,A,5213.0,N,00600.0,E,0.0,0.0,010118,003.1,W*00\r\n",
+	/* Summer time, with a GPGGA before any date is known */
+	"$GPGGA,120000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*78\r\n"
+	"$GPRMC,120000,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n"
+	"$GPGGA,120000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*78\r\n"
+	"$GPZDA,120000,01,07,2017,00,00*49\r\n"
+};
+static const char  *expected[STREAMS] = {
+	"$GPRMC,005959,A,5213.0,N,00600.0,E,0.0,0.0,010118,003.1,W*6C\r\n"
+	"$GPZDA,005959,01,01,2018,00,00*43\r\n"
+	"$GPGGA,005959,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*7B\r\n",
+	"$GPRMC,140000,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*60\r\n"
+	"$GPGGA,140000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*7E\r\n"
+	"$GPZDA,140000,01,07,2017,00,00*4F\r\n"
+};
+
+/* Sentences of types not converted around a GPRMC, for the filter */
+static const char  *mixed[] = {
+	"$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75\r\n",
+	"$GLGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*25\r\n",
+	"$GPRMC,120000,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n",
+	"$GPZDA,120000,01,07,2017,00,00*49\r\n",
+	NULL
+};
+
+/* The summer time sentence with "00" lost, which leaves the checksum intact, and again in full */
+static const char  lost[] =
+	"$GPRMC,1200\0,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n"
+	"$GPRMC,120000,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n";
+
+/* A GPGGA past midnight before the GPRMC of the new day, the day after summer time started, and its conversion */
+static const char  midnight[] =
+	"$GPRMC,235959,A,5213.0,N,00600.0,E,0.0,0.0,250318,003.1,W*69\r\n"
+	"$GPGGA,000000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*7B\r\n"
+	"$GPRMC,000000,A,5213.0,N,00600.0,E,0.0,0.0,260318,003.1,W*6B\r\n";
+static const char  midnight_expected[] =
+	"$GPRMC,015959,A,5213.0,N,00600.0,E,0.0,0.0,260318,003.1,W*6A\r\n"
+	"$GPGGA,020000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*79\r\n"
+	"$GPRMC,020000,A,5213.0,N,00600.0,E,0.0,0.0,260318,003.1,W*69\r\n";
+
+/* One sentence for each reason to drop it, in the order of enum nmea_drop_t, then one for each reason to reject a GPRMC */
+static const char  dropped[] =
+	"x"
+	"$GPGSV,00000000000000000000000000000000000000000000000000000000000000000000000000000000\r\n"
+	"$GPRMC,1200\0,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n"
+	"$*1\r\n"
+	"$GPRMC,A,B\r\n"
+	"$GPRMC*XY\r\n"
+	"$GPRMC*00\r\n"
+	"$GPRMC,,,,,,,,,,,,,,,*67\r\n"
+	"$GPVTG,0.0,T,,M,0.0,N,0.0,K*60\r\n"
+	"$GPRMC,120000,A*09\r\n"
+	"$GPRMC,120000,V,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*71\r\n"
+	"$GPRMC,12000x,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*2E\r\n"
+	"$GPRMC,120000,A,5213.0,N,00600.0,E,0.0,0.0,320717,003.1,W*66\r\n";
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void handle_gprmc(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct stream_t  *stream = ctx->user;
+	rtcsecs_t        utc_secs;
+	unsigned char    dst;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+
+	if (lt_gprmc(&stream->cache, argc, argv, &utc_secs, &dst))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+	strncat(stream->out, sentence, OUT_LEN - strlen(stream->out) - 1);
+}
+
+
+static void handle_gpgga(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct stream_t  *stream = ctx->user;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+
+	if (lt_gpgga(&stream->cache, argc, argv))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+	strncat(stream->out, sentence, OUT_LEN - strlen(stream->out) - 1);
+}
+
+
+static void handle_gpzda(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	struct stream_t  *stream = ctx->user;
+	const char       *sentence;
+	char             out[NMEA_LEN_MAX + 1];
+	unsigned char    len;
+
+	if (lt_gpzda(&stream->cache, argc, argv))
+		return;
+	if ((sentence = nmea_ctx_build(out, argc, argv, &len)) == NULL)
+		return;
+	strncat(stream->out, sentence, OUT_LEN - strlen(stream->out) - 1);
+}
+
+
+static void pass_sentence(struct nmea_ctx_t *ctx, const char *sentence, unsigned char len)
+{
+	struct stream_t  *stream = ctx->user;
+
+	snprintf(&stream->out[strlen(stream->out)], OUT_LEN - strlen(stream->out), "$%.*s\r\n", len, sentence);
+}
+
+
+/* Feed len bytes through nmea_ctx_frame(), framed the way the UART1 rx interrupt does */
+static void feed_frames(struct nmea_ctx_t *ctx, const char *in, size_t len)
+{
+	char           frame[NMEA_LEN_MAX + 1];
+	unsigned char  frame_len = 0;
+	unsigned char  filling = 0;
+	size_t         ndx;
+
+	for (ndx = 0; ndx < len; ndx++) {
+		if (!filling) {
+			filling = in[ndx] == '$';
+			frame_len = 0;
+			continue;
+		}
+		if (in[ndx] != '\r' && in[ndx] != '\n') {
+			frame[frame_len++] = in[ndx];
+			if (frame_len < sizeof(frame) - 1)
+				continue;
+		}
+		frame[frame_len] = '\0';
+		nmea_ctx_frame(ctx, frame, frame_len);
+		filling = 0;
+	}
+}
+
+
+/*
+ * Only wants GPRMC, and checks the others are dropped or passed on as
+ * received, whether parsed character by character or framed elsewhere.
+ */
+static void test_filter(void)
+{
+	static const enum filter_mode_t  modes[] = { FILTER_DROP, FILTER_PASS };
+	struct stream_t                  stream;
+	char                             expect[OUT_LEN];
+	const char                       *ch;
+	unsigned char                    mode;
+	unsigned char                    framed;
+	unsigned char                    ndx;
+
+	for (mode = 0; mode < sizeof(modes) / sizeof(modes[0]); mode++) {
+		filter_set(modes[mode], FILTER_TALKERS_DEFAULT, 0x01);
+		expect[0] = '\0';
+		for (ndx = 0; mixed[ndx]; ndx++) {
+			if (!strncmp(mixed[ndx], "$GPRMC", 6))
+				strncat(expect, expected[1], strcspn(expected[1], "\n") + 1);
+			else if (modes[mode] == FILTER_PASS)
+				strcat(expect, mixed[ndx]);
+		}
+
+		for (framed = 0; framed < 2; framed++) {
+			nmea_ctx_init(&stream.ctx, nmea, &stream);
+			stream.ctx.filter = filter_address;
+			stream.ctx.pass   = pass_sentence;
+			memset(&stream.cache, 0, sizeof(stream.cache));
+			stream.out[0] = '\0';
+			for (ndx = 0; mixed[ndx]; ndx++) {
+				if (framed)
+					feed_frames(&stream.ctx, mixed[ndx], strlen(mixed[ndx]));
+				else
+					for (ch = mixed[ndx]; *ch; ch++)
+						nmea_ctx_char(&stream.ctx, *ch);
+			}
+			if (strcmp(stream.out, expect) ||
+			    stream.ctx.stat.filtered != (modes[mode] == FILTER_DROP ? 3 : 0) ||
+			    stream.ctx.stat.passed != (modes[mode] == FILTER_PASS ? 3 : 0) ||
+			    stream.ctx.stat.valid != 1 ||
+			    stream.ctx.stat.drops[NMEA_DROP_OOB] != 0) {
+				fprintf(stderr, "Error: filter mode %u (framed %u) produced '%s', expected '%s'\n", modes[mode], framed, stream.out, expect);
+				exit(EXIT_FAILURE);
+			}
+		}
+	}
+	filter_set(FILTER_OFF, FILTER_TALKERS_DEFAULT, FILTER_TYPES_DEFAULT);
+}
+
+
+/*
+ * Every sentence of dropped[] has to show up in its own drop or reject
+ * counter, and nowhere else. Sentences framed elsewhere have no bytes out of
+ * band.
+ */
+static void test_drops(void)
+{
+	struct stream_t  stream;
+	size_t           ndx;
+	unsigned char    framed;
+
+	for (framed = 0; framed < 2; framed++) {
+		nmea_ctx_init(&stream.ctx, nmea, &stream);
+		memset(&stream.cache, 0, sizeof(stream.cache));
+		stream.out[0] = '\0';
+		if (framed)
+			feed_frames(&stream.ctx, dropped, sizeof(dropped) - 1);
+		else
+			for (ndx = 0; ndx < sizeof(dropped) - 1; ndx++)
+				nmea_ctx_char(&stream.ctx, dropped[ndx]);
+
+		for (ndx = 0; ndx < NMEA_DROPS; ndx++) {
+			if (stream.ctx.stat.drops[ndx] != (ndx == NMEA_DROP_OOB && framed ? 0 : 1)) {
+				fprintf(stderr, "Error: drop reason %u (framed %u) counted %u times\n", (unsigned int)ndx, framed, stream.ctx.stat.drops[ndx]);
+				exit(EXIT_FAILURE);
+			}
+		}
+		if (stream.cache.rejected.args != 1 || stream.cache.rejected.status != 1 ||
+		    stream.cache.rejected.number != 1 || stream.cache.rejected.range != 1 ||
+		    stream.out[0] != '\0') {
+			fprintf(stderr, "Error: GPRMC rejected %u, %u, %u and %u times (framed %u)\n",
+			        stream.cache.rejected.args, stream.cache.rejected.status,
+			        stream.cache.rejected.number, stream.cache.rejected.range, framed);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+
+
+#ifdef LT_PREDICT
+/* Fills in the arguments of a GPRMC sentence that lt_gprmc() looks at */
+static void make_gprmc(rtcsecs_t secs, char time[16], char date[16], char *argv[10])
+{
+	struct rtctime_t  utc;
+	unsigned char     ndx;
+
+	rtc_secs2time(secs, &utc);
+	sprintf(time, "%02u%02u%02u", utc.hour, utc.min, utc.sec);
+	sprintf(date, "%02u%02u%02u", utc.day, utc.mon + 1, utc.year % 100);
+	for (ndx = 0; ndx < 10; ndx++)
+		argv[ndx] = "";
+	argv[1] = time;
+	argv[2] = "A";
+	argv[9] = date;
+}
+
+
+/*
+ * Converts consecutive seconds across a new year and both DST switches, with
+ * a prediction in between and without any cache, which must agree. One second
+ * is skipped halfway, which must miss the prediction.
+ */
+static void test_predict(void)
+{
+	static const struct rtctime_t  starts[] = {
+		{ 50, 59, 23, 31, 11, 17 },     /* 2017-12-31 23:59:50 */
+		{ 50, 59,  0, 25,  2, 18 },     /* 2018-03-25 00:59:50, summer time starts at 01:00 */
+		{ 50, 59,  0, 28,  9, 18 },     /* 2018-10-28 00:59:50, summer time ends at 01:00 */
+	};
+	struct lt_cache_t              cache;
+	unsigned char                  run;
+	unsigned char                  step;
+
+	for (run = 0; run < sizeof(starts) / sizeof(starts[0]); run++) {
+		rtcsecs_t  secs;
+
+		memset(&cache, 0, sizeof(cache));
+		rtc_time2secs(&starts[run], &secs);
+		for (step = 0; step < PREDICT_STEPS; step++, secs++) {
+			char           time[2][16];
+			char           date[2][16];
+			char           *args[2][10];
+			rtcsecs_t      utc_secs[2];
+			unsigned char  dst[2];
+
+			if (step == PREDICT_STEPS / 2)
+				secs++;
+			make_gprmc(secs, time[0], date[0], args[0]);
+			make_gprmc(secs, time[1], date[1], args[1]);
+			if (lt_gprmc(&cache, 10, args[0], &utc_secs[0], &dst[0]) ||
+			    lt_gprmc(NULL, 10, args[1], &utc_secs[1], &dst[1]) ||
+			    strcmp(time[0], time[1]) || strcmp(date[0], date[1]) ||
+			    utc_secs[0] != utc_secs[1] || dst[0] != dst[1]) {
+				fprintf(stderr, "Error: predicted %s %s, expected %s %s\n", time[0], date[0], time[1], date[1]);
+				exit(EXIT_FAILURE);
+			}
+			lt_predict(&cache);
+		}
+		/* Only the first second and the one after the gap are converted */
+		if (cache.hits != PREDICT_STEPS - 2 || cache.conversions != 2) {
+			fprintf(stderr, "Error: %lu hits and %lu conversions in run %u\n", cache.hits, cache.conversions, run);
+			exit(EXIT_FAILURE);
+		}
+	}
+}
+#endif /* LT_PREDICT */
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+int main(int argc, char* argv[])
+{
+	struct stream_t  stream[STREAMS];
+	size_t           ndx[STREAMS] = { 0 };
+	unsigned char    busy;
+	unsigned char    s;
+
+	for (s = 0; s < STREAMS; s++) {
+		nmea_ctx_init(&stream[s].ctx, nmea, &stream[s]);
+		memset(&stream[s].cache, 0, sizeof(stream[s].cache));
+		stream[s].out[0] = '\0';
+	}
+
+	/* Feed the streams byte by byte, interleaved, so each sentence is parsed while the other stream is mid-sentence */
+	do {
+		busy = 0;
+		for (s = 0; s < STREAMS; s++) {
+			if (in[s][ndx[s]]) {
+				nmea_ctx_char(&stream[s].ctx, in[s][ndx[s]++]);
+				busy = 1;
+			}
+		}
+	} while (busy);
+
+	for (s = 0; s < STREAMS; s++) {
+		if (strcmp(stream[s].out, expected[s])) {
+			fprintf(stderr, "Error: stream %u produced '%s', expected '%s'\n", s, stream[s].out, expected[s]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	if (stream[0].ctx.stat.framed != 4 || stream[0].ctx.stat.valid != 3 ||
+	    stream[1].ctx.stat.framed != 4 || stream[1].ctx.stat.valid != 4 ||
+	    stream[0].ctx.stat.drops[NMEA_DROP_OOB] != 2 || stream[0].ctx.stat.drops[NMEA_DROP_BAD_CHECKSUM] != 1) {
+		fprintf(stderr, "Error: unexpected statistics\n");
+		exit(EXIT_FAILURE);
+	}
+	/* The sentences of an epoch share one conversion */
+	if (stream[0].cache.conversions != 1 || stream[1].cache.conversions != 1) {
+		fprintf(stderr, "Error: %lu and %lu conversions, expected one per stream\n",
+		        stream[0].cache.conversions, stream[1].cache.conversions);
+		exit(EXIT_FAILURE);
+	}
+
+	/* A sentence with lost characters must be dropped, whatever its checksum */
+	nmea_ctx_init(&stream[0].ctx, nmea, &stream[0]);
+	stream[0].out[0] = '\0';
+	for (ndx[0] = 0; ndx[0] < sizeof(lost) - 1; ndx[0]++)
+		nmea_ctx_char(&stream[0].ctx, lost[ndx[0]]);
+	/* Only the GPRMC that comes first in the summer time stream is expected */
+	if (strlen(stream[0].out) != strcspn(expected[1], "\n") + 1 ||
+	    strncmp(stream[0].out, expected[1], strlen(stream[0].out)) ||
+	    stream[0].ctx.stat.framed != 2 || stream[0].ctx.stat.valid != 1) {
+		fprintf(stderr, "Error: sentence with lost characters produced '%s'\n", stream[0].out);
+		exit(EXIT_FAILURE);
+	}
+
+	/* A GPGGA past midnight takes the date of the next day, and leaves that conversion for the GPRMC of its epoch */
+	nmea_ctx_init(&stream[0].ctx, nmea, &stream[0]);
+	memset(&stream[0].cache, 0, sizeof(stream[0].cache));
+	stream[0].out[0] = '\0';
+	for (ndx[0] = 0; ndx[0] < sizeof(midnight) - 1; ndx[0]++)
+		nmea_ctx_char(&stream[0].ctx, midnight[ndx[0]]);
+	if (strcmp(stream[0].out, midnight_expected) || stream[0].cache.conversions != 2) {
+		fprintf(stderr, "Error: GPGGA past midnight produced '%s' in %lu conversions\n", stream[0].out, stream[0].cache.conversions);
+		exit(EXIT_FAILURE);
+	}
+
+#ifdef LT_PREDICT
+	test_predict();
+#endif /* LT_PREDICT */
+
+	/* Sentences framed elsewhere must be handled the same */
+	for (s = 0; s < STREAMS; s++) {
+		nmea_ctx_init(&stream[s].ctx, nmea, &stream[s]);
+		memset(&stream[s].cache, 0, sizeof(stream[s].cache));
+		stream[s].out[0] = '\0';
+		feed_frames(&stream[s].ctx, in[s], strlen(in[s]));
+		if (strcmp(stream[s].out, expected[s])) {
+			fprintf(stderr, "Error: framed stream %u produced '%s', expected '%s'\n", s, stream[s].out, expected[s]);
+			exit(EXIT_FAILURE);
+		}
+	}
+	nmea_ctx_init(&stream[0].ctx, nmea, &stream[0]);
+	stream[0].out[0] = '\0';
+	feed_frames(&stream[0].ctx, lost, sizeof(lost) - 1);
+	if (strlen(stream[0].out) != strcspn(expected[1], "\n") + 1 ||
+	    stream[0].ctx.stat.framed != 2 || stream[0].ctx.stat.valid != 1) {
+		fprintf(stderr, "Error: framed sentence with lost characters produced '%s'\n", stream[0].out);
+		exit(EXIT_FAILURE);
+	}
+
+	test_filter();
+	test_drops();
+
+	fprintf(stderr, "Test completed successfully\n");
+
+	return EXIT_SUCCESS;
+}
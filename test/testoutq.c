@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uart1.h"
+#include "filter.h"
+#include "nmea.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define OUT_LEN                 256
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static void handle_time(struct nmea_ctx_t *ctx, int argc, char *argv[]);
+const struct nmea_t  nmea[] = {
+	{"GPRMC", handle_time},
+	{"GPGGA", handle_time},
+	{"GPZDA", handle_time},
+	{NULL,    NULL}
+};
+
+/* Received while the sink is still busy with the first sentence, with GSV and GSA passed on by the filter */
+static const char  rmc[] = "$GPRMC,120000,A,5213.0,N,00600.0,E,0.0,0.0,010717,003.1,W*66\r\n";
+static const char  gsv[] = "$GPGSV,2,1,08,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45*75\r\n";
+static const char  gga[] = "$GPGGA,120000,5213.0,N,00600.0,E,1,08,1.0,10.0,M,46.0,M,,*78\r\n";
+static const char  gsa[] = "$GLGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1*25\r\n";
+
+static const char  *policy_names[NMEA_OUTQ_POLICIES] = {
+	"drop-new", "drop-old", "latest", "time-first"
+};
+/* What gets out of the two-sentence queue, per policy: whatever's left after the one being sent */
+static const char  *expected_second[NMEA_OUTQ_POLICIES] = {
+	gsv, gsa, gsa, gga
+};
+
+static const char     *in;              /* Left to receive */
+static char           out[OUT_LEN];     /* Sent, concatenated */
+static unsigned int   out_len;
+static unsigned char  busy;             /* The sink is still taking the last sentence */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+/* Forward the sentences carrying the time as they are, rebuilt from their fields */
+static void handle_time(struct nmea_ctx_t *ctx, int argc, char *argv[])
+{
+	(void)ctx;
+	nmea_send(argc, argv);
+}
+
+
+static void run(enum nmea_outq_policy_t policy, const char *input)
+{
+	char  expected[OUT_LEN];
+
+	nmea_outq_policy(policy);
+	in      = input;
+	out_len = 0;
+	busy    = 0;
+
+	/* Receive everything while the sink takes its time with the first sentence */
+	while (nmea_work())
+		;
+
+	/* Let the sink catch up */
+	do {
+		busy = 0;
+		nmea_work();
+	} while (busy);
+
+	out[out_len] = '\0';
+	snprintf(expected, sizeof(expected), "%s%s", rmc, expected_second[policy]);
+	if (strcmp(out, expected)) {
+		fprintf(stderr, "Error: %s sent\n%s\ninstead of\n%s\n", policy_names[policy], out, expected);
+		exit(EXIT_FAILURE);
+	}
+	printf("%s: sent %.5s after %.5s\n", policy_names[policy], &expected_second[policy][1], &rmc[1]);
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+unsigned char uart1_read(char *buf, unsigned char len)
+{
+	unsigned char  ndx;
+
+	for (ndx = 0; ndx < len && *in; ndx++)
+		buf[ndx] = *in++;
+
+	return ndx;
+}
+
+
+unsigned char uart1_send(const char *data, unsigned char len)
+{
+	if (out_len + len >= OUT_LEN) {
+		fprintf(stderr, "Error: too much output\n");
+		exit(EXIT_FAILURE);
+	}
+	memcpy(&out[out_len], data, len);
+	out_len += len;
+	busy = 1;
+
+	return 1;
+}
+
+
+unsigned char uart1_sending(void)
+{
+	return busy;
+}
+
+
+int main(int argc, char* argv[])
+{
+	char                     input[OUT_LEN];
+	enum nmea_outq_policy_t  policy;
+
+	filter_set(FILTER_PASS, FILTER_TALKERS_DEFAULT, FILTER_TYPES_DEFAULT);
+	snprintf(input, sizeof(input), "%s%s%s%s", rmc, gsv, gga, gsa);
+	for (policy = NMEA_OUTQ_DROP_NEW; policy < NMEA_OUTQ_POLICIES; policy++)
+		run(policy, input);
+
+	fprintf(stderr, "Test completed successfully\n");
+
+	return EXIT_SUCCESS;
+}
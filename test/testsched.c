@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "event.h"
+#include "sched.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define LOG_LEN                 32
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static unsigned char  task_nmea(void);
+static unsigned char  task_console(void);
+const struct task_t   tasks[] = {
+	{"nmea",    EVENT_UART1_RX | EVENT_UART1_EOL, task_nmea},
+	{"cmdline", EVENT_UART2_RX | EVENT_UART2_EOL, task_console},
+	{NULL,      0,                                NULL}
+};
+
+static char           log_buf[LOG_LEN + 1];  /* Trace of idles ('.') and task runs ('N', 'C') */
+static unsigned int   log_len;
+static unsigned int   nmea_left;             /* Runs after which the NMEA task reports being done */
+static unsigned int   console_left;          /* Runs after which the console task reports being done */
+static unsigned int   now;                   /* Model of the free-running time base */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+static void log_char(char ch)
+{
+	if (log_len < LOG_LEN)
+		log_buf[log_len++] = ch;
+	log_buf[log_len] = '\0';
+}
+
+
+static unsigned char task_nmea(void)
+{
+	log_char('N');
+	now += 10;
+	return nmea_left ? (unsigned char)--nmea_left : 0;
+}
+
+
+static unsigned char task_console(void)
+{
+	log_char('C');
+	now += 100;
+	/* A burst of NMEA arriving while the console is busy */
+	if (console_left == 2)
+		event_post(EVENT_UART1_RX);
+	return console_left ? (unsigned char)--console_left : 0;
+}
+
+
+static void reset(void)
+{
+	sched_init();
+	event_init();
+	log_len      = 0;
+	log_buf[0]   = '\0';
+	nmea_left    = 0;
+	console_left = 0;
+}
+
+
+static void run(unsigned int passes)
+{
+	while (passes--)
+		sched_run();
+}
+
+
+static void expect(const char *test, const char *expected)
+{
+	if (strcmp(log_buf, expected)) {
+		fprintf(stderr, "Error: %s produced '%s', expected '%s'\n", test, log_buf, expected);
+		exit(EXIT_FAILURE);
+	}
+}
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+/* Model of the idle state, only reached when all tasks are done */
+void event_idle_hook(void)
+{
+	log_char('.');
+	event_post(EVENT_RTC_SECOND);
+}
+
+
+unsigned int sched_now_hook(void)
+{
+	return now;
+}
+
+
+int main(int argc, char* argv[])
+{
+	const struct task_stat_t  *stat;
+
+	/* Without an event loop, a round runs every task once, in order of priority */
+	reset();
+	run(4);
+	expect("round", "NCNC");
+
+	/* A task with work left keeps running before lower-priority tasks */
+	reset();
+	nmea_left = 3;
+	run(4);
+	expect("work left", "NNNC");
+
+	/* NMEA arriving while the console has work left preempts it at the next pass */
+	reset();
+	console_left = 3;
+	run(6);
+	expect("preemption", "NCCNCN");
+
+	/* Run time accounting */
+	stat = sched_stat(1);
+	if (stat->runs != 3 || stat->ticks != 300 || stat->ticks_max != 100) {
+		fprintf(stderr, "Error: console task accounted %lu runs, %lu ticks, %u max\n", stat->runs, stat->ticks, stat->ticks_max);
+		exit(EXIT_FAILURE);
+	}
+	sched_reset_stats();
+	if (sched_stat(0)->runs || sched_stat(1)->ticks) {
+		fprintf(stderr, "Error: statistics not reset\n");
+		exit(EXIT_FAILURE);
+	}
+
+	fprintf(stderr, "Test completed successfully\n");
+
+	return EXIT_SUCCESS;
+}
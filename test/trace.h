@@ -0,0 +1 @@
+../trace.h
\ No newline at end of file
@@ -0,0 +1 @@
+../uart1.c
\ No newline at end of file
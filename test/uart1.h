@@ -0,0 +1 @@
+../uart1.h
\ No newline at end of file
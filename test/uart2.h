@@ -0,0 +1 @@
+../uart2.h
\ No newline at end of file
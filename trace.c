@@ -0,0 +1,75 @@
+/******************************************************************************/
+/* File    : trace.c                                                          */
+/* Function: Binary trace ring                                                */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* Records events as an id, one argument byte and a TMR1 time stamp, taking   */
+/* a few instructions instead of formatting a message, so tracing can stay    */
+/* on in production. The TMR1 overflow interrupt counts its wraps, which go   */
+/* into the entries too, so events up to 536 s apart can be measured. The     */
+/* ring keeps the latest TRACE_LEN events. The console dumps them in hex,     */
+/* host/tracedec turns that back into messages.                               */
+/* Only to be used from the main loop, not from interrupt context.            */
+/******************************************************************************/
+#include <xc.h>
+
+#include "trace.h"
+
+
+/******************************************************************************/
+/* Macros                                                                     */
+/******************************************************************************/
+#define TRACE_MASK              (TRACE_LEN - 1)
+
+
+/******************************************************************************/
+/* Global Data                                                                */
+/******************************************************************************/
+static struct trace_entry_t  ring[TRACE_LEN];
+static unsigned char         seq;     /* Free-running, the next entry goes at seq & TRACE_MASK */
+static unsigned char         used;    /* Number of entries in the ring */
+static volatile unsigned int wraps;   /* Free-running count of TMR1 overflows */
+
+
+/******************************************************************************/
+/* Functions                                                                  */
+/******************************************************************************/
+void trace(unsigned char id, unsigned char arg)
+{
+	struct trace_entry_t  *entry = &ring[seq & TRACE_MASK];
+
+	/* Read again if TMR1 overflowed meanwhile */
+	do {
+		entry->wraps = wraps;
+		entry->tick  = TMR1;
+	} while (entry->wraps != wraps);
+	entry->seq  = seq++;
+	entry->id   = id;
+	entry->arg  = arg;
+	if (used < TRACE_LEN)
+		used++;
+}
+
+
+/* Count a TMR1 overflow, from interrupt context */
+void trace_isr(void)
+{
+	wraps++;
+}
+
+
+/* The n-th oldest entry in the ring, or NULL if there are no more */
+const struct trace_entry_t *trace_entry(unsigned char nth)
+{
+	if (nth >= used)
+		return NULL;
+
+	return &ring[(unsigned char)(seq - used + nth) & TRACE_MASK];
+}
+
+
+void trace_clear(void)
+{
+	used = 0;
+}
@@ -0,0 +1,73 @@
+/******************************************************************************/
+/* File    : trace.h                                                          */
+/* Function: Header file of 'trace.c'                                         */
+/* Author  : agent                                                            */
+/* Copyright (C) 2026, agent                                                  */
+/*                                                                            */
+/* The event table is shared with the host decoder (host/tracedec.c), which   */
+/* is the only user of the messages, so they cost the firmware nothing.       */
+/******************************************************************************/
+#ifndef TRACE_H
+#define TRACE_H
+
+
+/******************************************************************************/
+/*** Macros                                                                 ***/
+/******************************************************************************/
+#define TRACE_LEN               8       /* Number of entries in the ring. Has to be a power of 2. Only trace what's out of the ordinary, or it's gone in seconds */
+#define TRACE_TICK_HZ           8000000UL  /* Entries are time stamped with TMR1, running at Fosc/4, and its overflows */
+#define TRACE_TAG               "@T"    /* Starts each dumped entry on the console */
+
+/* Trace events: X(id, message), where the message may format the one argument byte */
+#define TRACE_EVENTS(X) \
+	X(TRACE_BOOT,               "Boot") \
+	X(TRACE_NMEA_OOB,           "NMEA: Discarding OOB byte 0x%.2x") \
+	X(TRACE_NMEA_OVERSIZED,     "NMEA: Discarding over-sized sentence") \
+	X(TRACE_NMEA_LOST,          "NMEA: Dropping sentence with lost characters") \
+	X(TRACE_NMEA_UNDERSIZED,    "NMEA: Dropping under-sized sentence of %u bytes") \
+	X(TRACE_NMEA_NO_SEPARATOR,  "NMEA: Dropping sentence without checksum separator") \
+	X(TRACE_NMEA_BAD_HEX,       "NMEA: Dropping sentence with non-numerical checksum") \
+	X(TRACE_NMEA_BAD_CHECKSUM,  "NMEA: Dropping sentence with bad checksum 0x%.2x") \
+	X(TRACE_NMEA_TOO_MANY_ARGS, "NMEA: Dropping sentence with too many arguments") \
+	X(TRACE_NMEA_UNSUPPORTED,   "NMEA: Unsupported sentence") \
+	X(TRACE_NMEA_OUTQ_DROP,     "NMEA: Output queue dropped a sentence, %u queued") \
+	X(TRACE_LT_NUMBER,          "LT: Error converting time or date to a number")
+
+/* The host tools share the traced modules, but have no ring to trace into */
+#ifdef __x86_64__
+#define TRACE(id, arg)          ((void)0)
+#else
+#define TRACE(id, arg)          trace(id, arg)
+#endif /* __x86_64__ */
+
+
+/******************************************************************************/
+/*** Types                                                                  ***/
+/******************************************************************************/
+#define TRACE_ENUM(id, message) id,
+enum trace_id_t {
+	TRACE_EVENTS(TRACE_ENUM)
+	TRACE_IDS
+};
+#undef TRACE_ENUM
+
+struct trace_entry_t {
+	unsigned char  seq;                 /* Free-running count of traced events, to spot entries overwritten between dumps */
+	unsigned char  id;
+	unsigned char  arg;
+	unsigned int   wraps;               /* TMR1 overflows at the time of the event, extending tick to 32 bits, which wrap every 536 s */
+	unsigned int   tick;                /* TMR1 at the time of the event, wraps every 8.192 ms */
+};
+
+
+/******************************************************************************/
+/*** Functions                                                              ***/
+/******************************************************************************/
+void          trace         (unsigned char  id,
+                             unsigned char  arg);
+void          trace_isr     (void);
+const struct trace_entry_t *trace_entry(unsigned char  nth);
+void          trace_clear   (void);
+
+
+#endif /* TRACE_H */
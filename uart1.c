@@ -2,6 +2,11 @@
 
 #include <stdio.h>
 
+#include "event.h"
+#include "filter.h"
+
+#include "uart1.h"
+
 
 /******************************************************************************/
 /* Macros                                                                     */
@@ -10,52 +15,340 @@
 
 #define RXBUFFER			/* Use buffers for received characters */
 //#define TXBUFFER			/* Use buffers for transmitted character (MAKE SURE TO ENABLE INTERRUPTS BEFORE TRANSMITTING ANYTHING) */
-#define BUFFER_SIZE		8	/* Buffer size. Has to be a power of 2 and congruent with queue.head and queue.tail or roll-overs need to be taken into account */
+#ifndef BUFFER_SIZE
+#define BUFFER_SIZE		8	/* Buffer size. Has to be a power of 2, no larger than 128, as queue.head and queue.tail run freely and are masked on use */
+#endif /* BUFFER_SIZE */
+#define BUFFER_MASK		(BUFFER_SIZE - 1)
 #define BUFFER_SPARE		2	/* Minumum number of free positions before issuing Xoff */
 
 #define INTDIV(n,d)             ((n)+((((n)>=0&&(d)>=0)||((n)<0&&(d)<0))?((d)/2):-((d)/2)))/(d)  /* Macro for integer division with proper round-off (BEWARE OF OVERFLOW!) */
-#define FREE(h,t,s)		(((h)>=(t))?((s)-((h)-(t))-1):((t)-(h))-1)
+#define USED(h,t)		((unsigned char)((h)-(t)))
+#define FREE(h,t,s)		((s)-USED(h,t))
 
 #define XON			0x11	/* ASCII value for Xon (^S) */
 #define XOFF			0x13	/* ASCII value for Xoff (^Q) */
+#ifdef RXBUFFER
+#define FLOW_PENDING()		(rx.xon_sent != rx.xon_state)	/* An Xon or Xoff is waiting to be sent */
+#else
+#define FLOW_PENDING()		0
+#endif /* RXBUFFER */
+#define EOL			'\n'	/* Line terminator reported as event */
+
+#define FRAME_HEADER		'$'	/* Starts a frame */
+#define FRAME_TRAILER		'\r'	/* Ends a frame, as does EOL */
+#define FRAME_FREE		0	/* Frame states */
+#define FRAME_FILLING		1
+#define FRAME_READY		2
+#define FRAME_NONE		0xff	/* frame_filling outside of a sentence */
+#define FRAME_SKIP		0xfe	/* frame_filling while dropping a sentence for lack of a free frame */
+
+#if UART1_RX_FRAMES && !defined(RXBUFFER)
+#error Framing sentences takes the rx interrupt of RXBUFFER
+#endif
 
 
 /******************************************************************************/
 /* Types                                                                      */
 /******************************************************************************/
+/*
+ * Single-producer/single-consumer queue: head is only written by the
+ * producer and tail only by the consumer. Both are bytes, so reading and
+ * writing them is atomic on the PIC and neither side needs to mask the
+ * other's interrupt. When full, the producer drops new data rather than
+ * touching tail.
+ */
 struct queue {
 	char		buffer[BUFFER_SIZE];	/* Here's where the data goes */
-	unsigned	head		: 3;	/* Index to a currently free position in buffer */
-	unsigned	tail		: 3;	/* Index to the oldest occupied position in buffer, if not equal to head */
+	unsigned char	head;			/* Free-running index to a currently free position in buffer */
+	unsigned char	tail;			/* Free-running index to the oldest occupied position in buffer, if not equal to head */
 	unsigned	xon_enabled	: 1;	/* Specifies if Xon/Xoff should be issued/adhered to */
 	unsigned	xon_state	: 1;	/* Keeps track of current Xon/Xoff state for this queue */
+	unsigned	xon_sent	: 1;	/* Xon/Xoff state last sent to the peer (rx queue only) */
+	unsigned	lost		: 1;	/* Characters were lost since the last one queued (rx queue only) */
+};
+
+#if UART1_RX_FRAMES
+/*
+ * A sentence framed by the rx interrupt. Only the rx interrupt takes free
+ * frames and fills them, and only the consumer releases ready ones, each
+ * side by writing state once done, so neither needs to mask the other's
+ * interrupt.
+ */
+struct frame {
+	char		data[UART1_FRAME_LEN];	/* What's between header and trailer, 0-terminated once ready */
+	unsigned char	len;
+	unsigned char	seq;			/* frames_done at completion, orders the ready frames */
+	unsigned char	state;			/* FRAME_FREE, FRAME_FILLING or FRAME_READY */
 };
+#endif /* UART1_RX_FRAMES */
 
 
 /******************************************************************************/
 /* Global data                                                                */
 /******************************************************************************/
 #ifdef RXBUFFER
-static struct queue		rx;
+static volatile struct queue	rx;
 #endif /* RXBUFFER */
 #ifdef TXBUFFER
-static struct queue		tx;
+static volatile struct queue	tx;
+#endif /* TXBUFFER */
+#if UART1_RX_FRAMES
+static volatile struct frame	frames[UART1_RX_FRAMES];
+static volatile unsigned char	frame_filling;	/* Index of the frame being filled, or FRAME_NONE or FRAME_SKIP */
+static volatile unsigned char	frames_done;	/* Free-running count of frames completed */
+#endif /* UART1_RX_FRAMES */
+static const char * volatile	tx_data;	/* Data handed to the tx interrupt by uart1_send() */
+static volatile unsigned char	tx_data_len;	/* Number of bytes of it left to send */
+static volatile unsigned int	rx_count;	/* Free-running count of received characters */
+static volatile unsigned int	rx_errors;	/* Free-running count of overrun and framing errors */
+static volatile unsigned char	rx_dropped;	/* Free-running count of characters dropped for a full buffer */
+#if UART1_RX_FRAMES
+static volatile unsigned char	rx_filtered;	/* Free-running count of sentences dropped by the filter */
+#endif /* UART1_RX_FRAMES */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+#ifdef RXBUFFER
+/* Have an Xon sent if required after dequeuing */
+static void rx_dequeued(void)
+{
+	if (rx.xon_enabled &&
+	    !rx.xon_state &&
+	    (rx.head == rx.tail)) {
+		rx.xon_state = 1;
+		TX1IE = 1;	/* The tx interrupt sends it */
+	}
+}
+
+
+#if UART1_RX_FRAMES
+/* Hand the frame being filled over to the consumer, from interrupt context */
+static void frame_complete(void)
+{
+	volatile struct frame	*frame = &frames[frame_filling];
+
+	frame->data[frame->len] = '\0';
+	frame->seq    = frames_done++;
+	frame->state  = FRAME_READY;
+	frame_filling = FRAME_NONE;
+	event_post(EVENT_UART1_RX | EVENT_UART1_EOL);
+}
+
+
+/* Add a character to the frame being filled, from interrupt context. A full frame is handed over as is, for the consumer to reject */
+static void frame_store(char ch)
+{
+	volatile struct frame	*frame = &frames[frame_filling];
+
+	frame->data[frame->len++] = ch;
+	if (frame->len >= UART1_FRAME_LEN - 1) {
+		frame_complete();
+		return;
+	}
+
+	/* Free the frame right away for a sentence the filter doesn't want, the rest of it is out of band */
+	if ((frame->len == NMEA_ADDRESS_LEN) &&
+	    (filter_address((const char *)frame->data) == NMEA_FILTER_DROP)) {
+		frame->state  = FRAME_FREE;
+		frame_filling = FRAME_NONE;
+		rx_filtered++;
+		/* Have an Xon sent if taking this frame sent an Xoff */
+		if (rx.xon_enabled &&
+		    !rx.xon_state) {
+			rx.xon_state = 1;
+			TX1IE = 1;
+		}
+	}
+}
+
+
+/* Take a free frame for a new sentence, from interrupt context. Without one, the sentence is dropped */
+static void frame_start(void)
+{
+	unsigned char	ndx;
+	unsigned char	spare = 0;
+
+	frame_filling = FRAME_SKIP;
+	for (ndx = 0; ndx < UART1_RX_FRAMES; ndx++) {
+		if (frames[ndx].state != FRAME_FREE)
+			continue;
+		if (frame_filling == FRAME_SKIP)
+			frame_filling = ndx;
+		else
+			spare++;
+	}
+	if (frame_filling == FRAME_SKIP) {
+		rx_dropped++;
+		return;
+	}
+	frames[frame_filling].len   = 0;
+	frames[frame_filling].state = FRAME_FILLING;
+
+	/* Have an Xoff sent when this was the last free frame, the tx interrupt sends it */
+	if (rx.xon_enabled &&
+	    rx.xon_state &&
+	    !spare) {
+		rx.xon_state = 0;
+		TX1IE = 1;
+	}
+}
+
+
+/* Frame a received character, from interrupt context */
+static void frame_put(char ch)
+{
+	if (frame_filling < UART1_RX_FRAMES) {
+		if ((ch == FRAME_TRAILER) || (ch == EOL)) {
+			frame_complete();
+			return;
+		}
+		frame_store(ch);
+	} else if (ch == FRAME_HEADER) {
+		/* Outside of a sentence only a header matters */
+		frame_start();
+	} else if (frame_filling == FRAME_SKIP) {
+		/* A sentence without a frame is dropped up to its trailer */
+		rx_dropped++;
+		if ((ch == FRAME_TRAILER) || (ch == EOL))
+			frame_filling = FRAME_NONE;
+	}
+	event_post(EVENT_UART1_RX);
+}
+#endif /* UART1_RX_FRAMES */
+
+
+/* Note the loss of received characters, from interrupt context */
+static void rx_lost(void)
+{
+#if UART1_RX_FRAMES
+	/* Mark the sentence being framed, so the consumer drops it */
+	if (frame_filling < UART1_RX_FRAMES)
+		frame_store(UART1_RX_LOST);
+#else
+	rx.lost = 1;
+#endif /* UART1_RX_FRAMES */
+	event_post(EVENT_UART1_ERR);
+}
+
+
+/*
+ * Queue a received character, from interrupt context. Any loss since the
+ * previous one is reported in front of it with UART1_RX_LOST, so the
+ * consumer can drop what the lost characters were part of. With
+ * UART1_RX_FRAMES, the character is framed instead, marking losses the same
+ * way.
+ */
+static void rx_put(char ch)
+{
+#ifdef TXBUFFER
+	/* Check if an Xon or Xoff needs to be handled */
+	if (tx.xon_enabled) {
+		if (tx.xon_state && (ch == XOFF)) {
+			tx.xon_state = 0;
+			if (!FLOW_PENDING())
+				TX1IE = 0;	/* Disable tx interrupt to stop transmitting */
+			return;
+		} else if (!tx.xon_state && (ch == XON)) {
+			tx.xon_state = 1;
+			/* Enable tx interrupt if there's anything to send */
+			if ((tx.head != tx.tail) || tx_data_len)
+				TX1IE = 1;
+			return;
+		}
+	}
 #endif /* TXBUFFER */
+#if UART1_RX_FRAMES
+	frame_put(ch);
+#else
+	/* Report an earlier loss, if the marker and the character both fit */
+	if (rx.lost) {
+		if (FREE(rx.head, rx.tail, BUFFER_SIZE) < 2) {
+			rx_dropped++;
+			return;
+		}
+		rx.buffer[rx.head & BUFFER_MASK] = UART1_RX_LOST;
+		rx.head++;
+		rx.lost = 0;
+	}
+	/* Drop the character on an overflow, as tail is owned by the consumer */
+	if (!FREE(rx.head, rx.tail, BUFFER_SIZE)) {
+		rx_dropped++;
+		rx.lost = 1;
+		return;
+	}
+	/* Queue the character */
+	rx.buffer[rx.head & BUFFER_MASK] = ch;
+	rx.head++;
+	/* Wake up the run loop */
+	event_post(ch == EOL ? EVENT_UART1_RX | EVENT_UART1_EOL : EVENT_UART1_RX);
+	/* Check if an Xoff is in required, the tx interrupt sends it rather than waiting for the transmitter here */
+	if (rx.xon_enabled &&
+	    rx.xon_state &&
+	    (FREE(rx.head, rx.tail, BUFFER_SIZE) <= (BUFFER_SPARE))) {
+		rx.xon_state = 0;
+		TX1IE = 1;
+	}
+#endif /* UART1_RX_FRAMES */
+}
+#endif /* RXBUFFER */
+
+
+/*
+ * Send a pending Xon/Xoff. Only to be called with TX1REG empty, from the tx
+ * interrupt or with it disabled. Returns 1 if one was sent.
+ */
+static unsigned char tx_flow(void)
+{
+#ifdef RXBUFFER
+	if (!FLOW_PENDING())
+		return 0;
+	TX1REG = rx.xon_state ? XON : XOFF;
+	rx.xon_sent = rx.xon_state;
+
+	return 1;
+#else
+	return 0;
+#endif /* RXBUFFER */
+}
 
 
 /******************************************************************************/
 /* Functions                                                                  */
 /******************************************************************************/
-void uart1_init(unsigned long bitrate, unsigned char flow)
+/*
+ * Changes the bit rate of both directions. The receiver is reset, so a
+ * character being received is lost, as is one being transmitted.
+ */
+void uart1_set_bitrate(unsigned long bitrate)
 {
 	unsigned long	divider = INTDIV(INTDIV(_XTAL_FREQ, 4UL), bitrate)-1;
 
+	RC1STAbits.CREN = 0;	/* Reset receiver */
+	BAUD1CONbits.BRG16 = 1;	/* Use 16-bit bit rate generation */
+	SP1BRGL =  divider & 0x00FF;
+	SP1BRGH = (divider & 0xFF00) >> 8;
+	RC1STAbits.CREN = 1;	/* Enable reception */
+}
+
+
+void uart1_init(unsigned long bitrate, unsigned char flow)
+{
 #ifdef RXBUFFER
 	rx.head        = 0;
 	rx.tail        = 0;
 	rx.xon_enabled = flow;
 	rx.xon_state   = 1;
+	rx.xon_sent    = 1;
+	rx.lost        = 0;
 #endif /* RXBUFFER */
+#if UART1_RX_FRAMES
+	for (frame_filling = 0; frame_filling < UART1_RX_FRAMES; frame_filling++)
+		frames[frame_filling].state = FRAME_FREE;
+	frame_filling  = FRAME_NONE;
+	frames_done    = 0;
+#endif /* UART1_RX_FRAMES */
 
 #ifdef TXBUFFER
 	tx.head        = 0;
@@ -64,9 +357,7 @@ void uart1_init(unsigned long bitrate, unsigned char flow)
 	tx.xon_state   = 1;
 #endif /* TXBUFFER */
 
-	BAUD1CONbits.BRG16 = 1;	/* Use 16-bit bit rate generation */
-	SP1BRGL =  divider & 0x00FF;
-	SP1BRGH = (divider & 0xFF00) >> 8;
+	uart1_set_bitrate(bitrate);
 
 	TX1STAbits.CSRC = 1;	/* Clock source from BRG */
 	TX1STAbits.BRGH = 1;	/* High-speed bit rate generation */
@@ -92,8 +383,56 @@ void uart1_init(unsigned long bitrate, unsigned char flow)
 }
 
 
+/* Reading a 16-bit counter takes two instructions, so keep the rx interrupt that counts out meanwhile */
+unsigned int uart1_rx_count(void)
+{
+	unsigned int  count;
+
+#ifdef RXBUFFER
+	RC1IE = 0;	/* Disable rx interrupt for concurrency */
+#endif /* RXBUFFER */
+	count = rx_count;
+#ifdef RXBUFFER
+	RC1IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
+
+	return count;
+}
+
+
+unsigned int uart1_rx_errors(void)
+{
+	unsigned int  errors;
+
+#ifdef RXBUFFER
+	RC1IE = 0;	/* Disable rx interrupt for concurrency */
+#endif /* RXBUFFER */
+	errors = rx_errors;
+#ifdef RXBUFFER
+	RC1IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
+
+	return errors;
+}
+
+
+unsigned char uart1_rx_dropped(void)
+{
+	return rx_dropped;
+}
+
+
+#if UART1_RX_FRAMES
+unsigned char uart1_rx_filtered(void)
+{
+	return rx_filtered;
+}
+#endif /* UART1_RX_FRAMES */
+
+
 void uart1_term(void)
 {
+	while (tx_data_len);
 #ifdef RXBUFFER
 	RC1IE = 0;	/* Disable rx interrupt */
 #endif /* RXBUFFER */
@@ -103,10 +442,11 @@ void uart1_term(void)
 #endif /* TXBUFFER */
 
 #ifdef RXBUFFER
-	if (rx.xon_enabled && rx.xon_state) {
+	if (rx.xon_enabled && rx.xon_sent) {
 		while(!TX1IF);
 		TX1REG = XOFF;
 		rx.xon_state = 0;
+		rx.xon_sent  = 0;
 	}
 #endif /* RXBUFFER */
 	while(!TX1IF);	/* Wait for the last character to go */
@@ -116,76 +456,105 @@ void uart1_term(void)
 }
 
 
+/*
+ * Receive errors only reset the receiver, so they never disturb a character
+ * being transmitted, and are reported in the queue as lost characters.
+ */
 void uart1_rx_isr(void)
 {
 #ifdef RXBUFFER
-	/* Handle overflow errors */
-	if (RC1STAbits.OERR) {
-		rx.buffer[rx.head] = RC1REG; /* Read RX register, but do not queue */
-		TX1STAbits.TXEN = 0;
-		TX1STAbits.TXEN = 1;
-		RC1STAbits.CREN = 0;
-		RC1STAbits.CREN = 1;
-		return;
-	}
 	/* Handle framing errors */
 	if (RC1STAbits.FERR) {
-		rx.buffer[rx.head] = RC1REG; /* Read RX register, but do not queue */
-		TX1STAbits.TXEN = 0;
-		TX1STAbits.TXEN = 1;
-		return;
+		(void)RC1REG; /* Read RX register, but do not queue */
+		rx_errors++;
+		rx_lost();
+	} else {
+		/* Copy the character from RX register */
+		rx_count++;
+		rx_put(RC1REG);
+	}
+	/* Handle overrun errors, once the characters from before the overrun are out of the FIFO */
+	if (RC1STAbits.OERR && !RC1IF) {
+		RC1STAbits.CREN = 0;	/* Reset receiver */
+		RC1STAbits.CREN = 1;	/* Enable reception */
+		rx_errors++;
+		rx_lost();
 	}
-	/* Copy the character from RX register into RX queue */
-	rx.buffer[rx.head] = RC1REG;
+#endif /* RXBUFFER */
+}
+
+
+void uart1_tx_isr(void)
+{
+	/* Xon/Xoff go out of band, ahead of the queue and regardless of the peer's Xoff */
+	if (tx_flow())
+		return;
 #ifdef TXBUFFER
-	/* Check if an Xon or Xoff needs to be handled */
-	if (tx.xon_enabled) {
-		if (tx.xon_state && (rx.buffer[rx.head] == XOFF)) {
-			tx.xon_state = 0;
-			TX1IE = 0;	/* Disable tx interrupt to stop transmitting */
-			return;
-		} else if (!tx.xon_state && (rx.buffer[rx.head] == XON)) {
-			tx.xon_state = 1;
-			/* Enable tx interrupt if tx queue is not empty */
-			if (tx.head != tx.tail)
-				TX1IE = 1;
+	if (tx.xon_enabled && !tx.xon_state) {
+		/* Held by the peer */
+		TX1IE = 0;
+		return;
+	}
+	if (tx.head != tx.tail) {
+		/* Copy the character from the TX queue into the TX register */
+		TX1REG = tx.buffer[tx.tail & BUFFER_MASK];
+		/* Dequeue the character */
+		tx.tail++;
+		/* Keep the tx interrupt enabled if there's more to send */
+		if ((tx.head != tx.tail) || tx_data_len)
 			return;
-		}
+		TX1IE = 0;
+		return;
 	}
 #endif /* TXBUFFER */
-	/* Queue the character */
-	rx.head++;
-	/* Check if an Xoff is in required */
-	if (rx.xon_enabled &&
-	    rx.xon_state &&
-	    (FREE(rx.head, rx.tail, BUFFER_SIZE) <= (BUFFER_SPARE))) {
-		while(!TX1IF);	// TBD: Could potentially wait forever here
-		TX1REG = XOFF;
-		rx.xon_state = 0;
+	/* Then the data handed over by uart1_send() */
+	if (tx_data_len) {
+		TX1REG = *tx_data++;
+		if (--tx_data_len)
+			return;
+		/* Done, the next can be handed over */
+		event_post(EVENT_UART1_TX);
 	}
-	/* Check for an overflow */
-	if (rx.head == rx.tail)
-		/* Dequeue the oldest character */
-		rx.tail++;
-#endif /* RXBUFFER */
+	/* Disable tx interrupt, nothing left to send */
+	TX1IE = 0;
 }
 
 
-void uart1_tx_isr(void)
+/* Test if a character can be sent without waiting */
+unsigned char uart1_tx_ready(void)
 {
 #ifdef TXBUFFER
-	/* Copy the character from the TX queue into the TX register */
-	TX1REG = tx.buffer[tx.tail];
-	/* Dequeue the character */
-	tx.tail++;
-
-	/* Disable tx interrupt if queue is empty */
-	if (tx.head == tx.tail)
-		TX1IE = 0;
+	return FREE(tx.head, tx.tail, BUFFER_SIZE) != 0;
+#else
+	return RC1STAbits.SPEN && TX1IF;
 #endif /* TXBUFFER */
 }
 
 
+/*
+ * Hands len bytes to the tx interrupt to send after anything queued, so the
+ * caller doesn't wait for them. They have to stay put until
+ * uart1_sending() returns 0, which EVENT_UART1_TX announces. Returns 0
+ * without taking them while the previous ones are still being sent.
+ */
+unsigned char uart1_send(const char *data, unsigned char len)
+{
+	if (tx_data_len)
+		return 0;
+	tx_data     = data;
+	tx_data_len = len;	/* Written last, the tx interrupt only looks at tx_data when this is set */
+	TX1IE      = 1;
+
+	return 1;
+}
+
+
+unsigned char uart1_sending(void)
+{
+	return tx_data_len != 0;
+}
+
+
 void uart1_putch(char ch)
 {
 #ifdef TXBUFFER
@@ -197,16 +566,16 @@ void uart1_putch(char ch)
 #endif /* RXBUFFER */
 		TX1IE = 0;	/* Disable tx interrupt for concurrency */
 
-		/* Check if there's room in the queue ((tx.head + 1) != tx.tail won't work due to bitfields being cast) */
+		/* Check if there's room in the queue */
 		if (FREE(tx.head, tx.tail, BUFFER_SIZE)) {
 			/* Copy the character into the TX queue */
-			tx.buffer[tx.head] = ch;
+			tx.buffer[tx.head & BUFFER_MASK] = ch;
 			/* Queue the character */
 			tx.head++;
 			queued = 1;
 		} else
 			CLRWDT();
-		if (!tx.xon_enabled || tx.xon_state)
+		if (FLOW_PENDING() || !tx.xon_enabled || tx.xon_state)
 			TX1IE = 1;	/* Re-enable tx interrupt */
 #ifdef RXBUFFER
 		RC1IE = 1;	/* Re-enable rx interrupt */
@@ -215,23 +584,27 @@ void uart1_putch(char ch)
 #else
 	if (!RC1STAbits.SPEN)
 		return;
-	while(!TX1IF) {	/* Wait for TX1REG to be empty */
-		if (RC1STAbits.OERR) {
-			TX1STAbits.TXEN = 0;
-			TX1STAbits.TXEN = 1;
-			RC1STAbits.CREN = 0;
-			RC1STAbits.CREN = 1;
-		}
-		if (RC1STAbits.FERR) {
-			volatile unsigned char dummy;
-
-			dummy = RC1REG;
-			TX1STAbits.TXEN = 0;
-			TX1STAbits.TXEN = 1;
-		}
-		CLRWDT();
+	for (;;) {
+		/* Wait for TX1REG to be empty, receive errors are up to the receive path */
+		while(!TX1IF)
+			CLRWDT();
+#ifdef RXBUFFER
+		RC1IE = 0;	/* Disable rx interrupt for concurrency */
+#endif /* RXBUFFER */
+		TX1IE = 0;	/* Keep the tx interrupt off TX1REG */
+		/* A pending Xon/Xoff goes first, then wait for room again */
+		if (!tx_flow())
+			break;
+#ifdef RXBUFFER
+		RC1IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
 	}
 	TX1REG = ch;
+	if (tx_data_len)
+		TX1IE = 1;	/* Carry on with data handed over by uart1_send() */
+#ifdef RXBUFFER
+	RC1IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
 	CLRWDT();
 #endif /* TXBUFFER */
 }
@@ -242,55 +615,149 @@ char uart1_getch(void)
 #ifdef RXBUFFER
 	char  result = EOF;
 
-	RC1IE = 0;	/* Disable rx interrupt for concurrency */
-#ifdef TXBUFFER
-	TX1IE = 0;	/* Disable tx interrupt for concurrency */
-#endif /* TXBUFFER */
-
 	/* Check if there's anything to read */
 	if (rx.head != rx.tail) {
 		/* Copy the character from the RX queue */
-		result = rx.buffer[rx.tail];
+		result = rx.buffer[rx.tail & BUFFER_MASK];
 		/* Dequeue the character */
 		rx.tail++;
 		/* Check if an Xon is in required */
-		if (rx.xon_enabled &&
-		    !rx.xon_state &&
-		    (rx.head == rx.tail)) {
-			while(!TX1IF);
-			TX1REG = XON;
-			rx.xon_state = 1;
-		}
+		rx_dequeued();
 	}
 
-	RC1IE = 1;	/* Re-enable rx interrupt */
-#ifdef TXBUFFER
-	if ((tx.head != tx.tail) && (!tx.xon_enabled || tx.xon_state))
-		TX1IE = 1;	/* Re-enable tx interrupt */
-#endif /* TXBUFFER */
-
 	return result;
 
 #else /* !RXBUFFER */
 	if (!RCIF)
 		return EOF;
 
+	/* Reset only the receiver, leaving the transmitter alone */
 	if (RC1STAbits.OERR) {
-		TX1STAbits.TXEN = 0;
-		TX1STAbits.TXEN = 1;
 		RC1STAbits.CREN = 0;
 		RC1STAbits.CREN = 1;
-		return 0;
+		rx_errors++;
+		return UART1_RX_LOST;
 	}
 	if (RC1STAbits.FERR) {
-		volatile unsigned char dummy;
-
-		dummy = RC1REG;
-		TX1STAbits.TXEN = 0;
-		TX1STAbits.TXEN = 1;
-		return 0;
+		(void)RC1REG;
+		rx_errors++;
+		return UART1_RX_LOST;
 	}
 
+	rx_count++;
 	return RC1REG;
 #endif /* RXBUFFER */
 }
+
+
+/* Get the contiguous span of received characters, without dequeuing them */
+unsigned char uart1_rx_span(const char **data)
+{
+#ifdef RXBUFFER
+	unsigned char  used = USED(rx.head, rx.tail);  /* Snapshot, the producer can only add to it */
+	unsigned char  offset = rx.tail & BUFFER_MASK;
+
+	*data = (const char *)&rx.buffer[offset];
+
+	/* The span ends at the end of the buffer, the rest follows on the next call */
+	if (used > BUFFER_SIZE - offset)
+		used = BUFFER_SIZE - offset;
+
+	return used;
+#else /* !RXBUFFER */
+	*data = NULL;
+	return 0;
+#endif /* RXBUFFER */
+}
+
+
+/* Dequeue characters previously obtained through uart1_rx_span() */
+void uart1_rx_commit(unsigned char len)
+{
+#ifdef RXBUFFER
+	rx.tail += len;
+	rx_dequeued();
+#endif /* RXBUFFER */
+}
+
+
+/* Copy and dequeue up to len received characters, returns the number of characters copied */
+unsigned char uart1_read(char *buf, unsigned char len)
+{
+#ifdef RXBUFFER
+	unsigned char  count = 0;
+	unsigned char  head = rx.head;  /* Snapshot, the producer can only add to it */
+	unsigned char  tail = rx.tail;
+
+	while ((count < len) && (head != tail))
+		buf[count++] = rx.buffer[tail++ & BUFFER_MASK];
+	if (count) {
+		/* Dequeue everything copied at once */
+		rx.tail = tail;
+		rx_dequeued();
+	}
+
+	return count;
+#else /* !RXBUFFER */
+	char  ch;
+
+	if (!len || (ch = uart1_getch()) == (char)EOF)
+		return 0;
+	buf[0] = ch;
+
+	return 1;
+#endif /* RXBUFFER */
+}
+
+
+#if UART1_RX_FRAMES
+/*
+ * Get the n-th oldest sentence framed, without header and trailer, or NULL
+ * if there are no more. It stays put, and may be modified in place, until
+ * released.
+ */
+char *uart1_frame(unsigned char nth, unsigned char *len)
+{
+	unsigned char	done = frames_done;  /* Snapshot, frames completed after it are the newest */
+	unsigned char	ndx;
+	unsigned char	other;
+	unsigned char	older;
+
+	for (ndx = 0; ndx < UART1_RX_FRAMES; ndx++) {
+		if (frames[ndx].state != FRAME_READY)
+			continue;
+		/* Count the ready frames completed before this one */
+		for (other = 0, older = 0; other < UART1_RX_FRAMES; other++)
+			if ((frames[other].state == FRAME_READY) &&
+			    ((unsigned char)(done - frames[other].seq) > (unsigned char)(done - frames[ndx].seq)))
+				older++;
+		if (older == nth) {
+			*len = frames[ndx].len;
+			return (char *)frames[ndx].data;
+		}
+	}
+
+	return NULL;
+}
+
+
+/* Release a sentence obtained through uart1_frame(), for the rx interrupt to reuse */
+void uart1_frame_release(char *frame)
+{
+	unsigned char	ndx;
+
+	for (ndx = 0; ndx < UART1_RX_FRAMES; ndx++) {
+		if ((char *)frames[ndx].data == frame) {
+			frames[ndx].state = FRAME_FREE;
+			break;
+		}
+	}
+
+	/* Have an Xon sent, now there's a free frame */
+	if (rx.xon_enabled &&
+	    !rx.xon_state) {
+		rx.xon_state = 1;
+		TX1IE = 1;
+	}
+}
+#endif /* UART1_RX_FRAMES */
@@ -8,13 +8,38 @@
 #define UART1_H
 
 
+#define UART1_RX_LOST  '\0'	/* Read in place of characters lost to receive errors or a full buffer */
+#ifndef UART1_RX_FRAMES
+#define UART1_RX_FRAMES	2	/* Number of sentence buffers the rx interrupt frames into, 0 to queue characters for the main loop instead */
+#endif /* UART1_RX_FRAMES */
+#define UART1_FRAME_LEN	83	/* Size of a sentence buffer, holding what's between header and trailer, 0-terminated */
+
+
 void           uart1_init  (unsigned long  bitrate,
                             unsigned char  flow);
 void           uart1_term  (void);
+void           uart1_set_bitrate(unsigned long  bitrate);
+unsigned int   uart1_rx_count(void);
+unsigned int   uart1_rx_errors(void);
+unsigned char  uart1_rx_dropped(void);
 void           uart1_rx_isr(void);
 void           uart1_tx_isr(void);
+unsigned char  uart1_tx_ready(void);
+unsigned char  uart1_send  (const char     *data,
+                            unsigned char  len);
+unsigned char  uart1_sending(void);
 void           uart1_putch(char ch);
 char           uart1_getch(void);
+unsigned char  uart1_rx_span(const char     **data);
+void           uart1_rx_commit(unsigned char  len);
+unsigned char  uart1_read  (char           *buf,
+                            unsigned char  len);
+#if UART1_RX_FRAMES
+unsigned char  uart1_rx_filtered(void);
+char           *uart1_frame(unsigned char  nth,
+                            unsigned char  *len);
+void           uart1_frame_release(char    *frame);
+#endif /* UART1_RX_FRAMES */
 
 
 #endif /* UART1_H */
@@ -2,6 +2,10 @@
 
 #include <stdio.h>
 
+#include "event.h"
+
+#include "uart2.h"
+
 
 /******************************************************************************/
 /* Macros                                                                     */
@@ -9,26 +13,44 @@
 #define _XTAL_FREQ 32000000
 
 #define RXBUFFER			/* Use buffers for received characters */
-//#define TXBUFFER			/* Use buffers for transmitted character (MAKE SURE TO ENABLE INTERRUPTS BEFORE TRANSMITTING ANYTHING) */
-#define BUFFER_SIZE		8	/* Buffer size. Has to be a power of 2 and congruent with queue.head and queue.tail or roll-overs need to be taken into account */
+#define TXBUFFER			/* Use buffers for transmitted character (MAKE SURE TO ENABLE INTERRUPTS BEFORE TRANSMITTING ANYTHING) */
+#define BUFFER_SIZE		8	/* Buffer size. Has to be a power of 2, no larger than 128, as queue.head and queue.tail run freely and are masked on use */
+#define BUFFER_MASK		(BUFFER_SIZE - 1)
+#define TX_BUFFER_SIZE		UART2_TX_LEN	/* Transmit buffer size */
+#define TX_BUFFER_MASK		(TX_BUFFER_SIZE - 1)
 #define BUFFER_SPARE		2	/* Minumum number of free positions before issuing Xoff */
 
 #define INTDIV(n,d)             ((n)+((((n)>=0&&(d)>=0)||((n)<0&&(d)<0))?((d)/2):-((d)/2)))/(d)  /* Macro for integer division with proper round-off (BEWARE OF OVERFLOW!) */
-#define FREE(h,t,s)		(((h)>=(t))?((s)-((h)-(t))-1):((t)-(h))-1)
+#define USED(h,t)		((unsigned char)((h)-(t)))
+#define FREE(h,t,s)		((s)-USED(h,t))
 
 #define XON			0x11	/* ASCII value for Xon (^S) */
 #define XOFF			0x13	/* ASCII value for Xoff (^Q) */
+#ifdef RXBUFFER
+#define FLOW_PENDING()		(rx.xon_sent != rx.xon_state)	/* An Xon or Xoff is waiting to be sent */
+#else
+#define FLOW_PENDING()		0
+#endif /* RXBUFFER */
+#define EOL			'\n'	/* Line terminator reported as event */
 
 
 /******************************************************************************/
 /* Types                                                                      */
 /******************************************************************************/
+/*
+ * Single-producer/single-consumer queue: head is only written by the
+ * producer and tail only by the consumer. Both are bytes, so reading and
+ * writing them is atomic on the PIC and neither side needs to mask the
+ * other's interrupt. When full, the producer drops new data rather than
+ * touching tail, except for the tx queue under UART2_TX_DROP_OLD, which
+ * masks the tx interrupt to do so.
+ */
 struct queue {
-	char		buffer[BUFFER_SIZE];	/* Here's where the data goes */
-	unsigned	head		: 3;	/* Index to a currently free position in buffer */
-	unsigned	tail		: 3;	/* Index to the oldest occupied position in buffer, if not equal to head */
+	unsigned char	head;			/* Free-running index to a currently free position in buffer */
+	unsigned char	tail;			/* Free-running index to the oldest occupied position in buffer, if not equal to head */
 	unsigned	xon_enabled	: 1;	/* Specifies if Xon/Xoff should be issued/adhered to */
 	unsigned	xon_state	: 1;	/* Keeps track of current Xon/Xoff state for this queue */
+	unsigned	xon_sent	: 1;	/* Xon/Xoff state last sent to the peer (rx queue only) */
 };
 
 
@@ -36,11 +58,55 @@ struct queue {
 /* Global data                                                                */
 /******************************************************************************/
 #ifdef RXBUFFER
-static struct queue		rx;
+static volatile struct queue	rx;
+static volatile char		rx_buffer[BUFFER_SIZE];
 #endif /* RXBUFFER */
 #ifdef TXBUFFER
-static struct queue		tx;
+static volatile struct queue	tx;
+static volatile char		tx_buffer[TX_BUFFER_SIZE];
+static enum uart2_tx_policy_t	tx_policy = UART2_TX_DROP_NEW;
+static unsigned char		tx_wait;	/* Wait for room regardless of tx_policy */
+static unsigned long		tx_lost;	/* Characters dropped by the policy */
 #endif /* TXBUFFER */
+static const char * volatile	tx_data;	/* Data handed to the tx interrupt by uart2_send() */
+static volatile unsigned char	tx_data_len;	/* Number of bytes of it left to send */
+static unsigned char		console = 1;	/* Console output enabled */
+
+
+/******************************************************************************/
+/* Static functions                                                           */
+/******************************************************************************/
+#ifdef RXBUFFER
+/* Have an Xon sent if required after dequeuing */
+static void rx_dequeued(void)
+{
+	if (rx.xon_enabled &&
+	    !rx.xon_state &&
+	    (rx.head == rx.tail)) {
+		rx.xon_state = 1;
+		TX2IE = 1;	/* The tx interrupt sends it */
+	}
+}
+#endif /* RXBUFFER */
+
+
+/*
+ * Send a pending Xon/Xoff. Only to be called with TX2REG empty, from the tx
+ * interrupt or with it disabled. Returns 1 if one was sent.
+ */
+static unsigned char tx_flow(void)
+{
+#ifdef RXBUFFER
+	if (!FLOW_PENDING())
+		return 0;
+	TX2REG = rx.xon_state ? XON : XOFF;
+	rx.xon_sent = rx.xon_state;
+
+	return 1;
+#else
+	return 0;
+#endif /* RXBUFFER */
+}
 
 
 /******************************************************************************/
@@ -55,6 +121,7 @@ void uart2_init(unsigned long bitrate, unsigned char flow)
 	rx.tail        = 0;
 	rx.xon_enabled = flow;
 	rx.xon_state   = 1;
+	rx.xon_sent    = 1;
 #endif /* RXBUFFER */
 
 #ifdef TXBUFFER
@@ -94,6 +161,7 @@ void uart2_init(unsigned long bitrate, unsigned char flow)
 
 void uart2_term(void)
 {
+	while (tx_data_len);
 #ifdef RXBUFFER
 	RC2IE = 0;	/* Disable rx interrupt */
 #endif /* RXBUFFER */
@@ -103,10 +171,11 @@ void uart2_term(void)
 #endif /* TXBUFFER */
 
 #ifdef RXBUFFER
-	if (rx.xon_enabled && rx.xon_state) {
+	if (rx.xon_enabled && rx.xon_sent) {
 		while(!TX2IF);
 		TX2REG = XOFF;
 		rx.xon_state = 0;
+		rx.xon_sent  = 0;
 	}
 #endif /* RXBUFFER */
 	while(!TX2IF);	/* Wait for the last character to go */
@@ -119,75 +188,150 @@ void uart2_term(void)
 void uart2_rx_isr(void)
 {
 #ifdef RXBUFFER
+	char  ch;
+
 	/* Handle overflow errors */
 	if (RC2STAbits.OERR) {
-		rx.buffer[rx.head] = RC2REG; /* Read RX register, but do not queue */
-		TX2STAbits.TXEN = 0;
-		TX2STAbits.TXEN = 1;
-		RC2STAbits.CREN = 0;
+		(void)RC2REG; /* Read RX register, but do not queue */
+		RC2STAbits.CREN = 0;	/* Reset only the receiver, leaving the transmitter alone */
 		RC2STAbits.CREN = 1;
 		return;
 	}
 	/* Handle framing errors */
 	if (RC2STAbits.FERR) {
-		rx.buffer[rx.head] = RC2REG; /* Read RX register, but do not queue */
-		TX2STAbits.TXEN = 0;
-		TX2STAbits.TXEN = 1;
+		(void)RC2REG; /* Read RX register, but do not queue */
 		return;
 	}
-	/* Copy the character from RX register into RX queue */
-	rx.buffer[rx.head] = RC2REG;
+	/* Copy the character from RX register */
+	ch = RC2REG;
 #ifdef TXBUFFER
 	/* Check if an Xon or Xoff needs to be handled */
 	if (tx.xon_enabled) {
-		if (tx.xon_state && (rx.buffer[rx.head] == XOFF)) {
+		if (tx.xon_state && (ch == XOFF)) {
 			tx.xon_state = 0;
-			TX2IE = 0;	/* Disable tx interrupt to stop transmitting */
+			if (!FLOW_PENDING())
+				TX2IE = 0;	/* Disable tx interrupt to stop transmitting */
 			return;
-		} else if (!tx.xon_state && (rx.buffer[rx.head] == XON)) {
+		} else if (!tx.xon_state && (ch == XON)) {
 			tx.xon_state = 1;
-			/* Enable tx interrupt if tx queue is not empty */
-			if (tx.head != tx.tail)
+			/* Enable tx interrupt if there's anything to send */
+			if ((tx.head != tx.tail) || tx_data_len)
 				TX2IE = 1;
 			return;
 		}
 	}
 #endif /* TXBUFFER */
+	/* Drop the character on an overflow, as tail is owned by the consumer */
+	if (!FREE(rx.head, rx.tail, BUFFER_SIZE))
+		return;
 	/* Queue the character */
+	rx_buffer[rx.head & BUFFER_MASK] = ch;
 	rx.head++;
-	/* Check if an Xoff is in required */
+	/* Wake up the run loop */
+	event_post(ch == EOL ? EVENT_UART2_RX | EVENT_UART2_EOL : EVENT_UART2_RX);
+	/* Check if an Xoff is in required, the tx interrupt sends it rather than waiting for the transmitter here */
 	if (rx.xon_enabled &&
 	    rx.xon_state &&
 	    (FREE(rx.head, rx.tail, BUFFER_SIZE) <= (BUFFER_SPARE))) {
-		while(!TX2IF);	// TBD: Could potentially wait forever here
-		TX2REG = XOFF;
 		rx.xon_state = 0;
+		TX2IE = 1;
 	}
-	/* Check for an overflow */
-	if (rx.head == rx.tail)
-		/* Dequeue the oldest character */
-		rx.tail++;
 #endif /* RXBUFFER */
 }
 
 
 void uart2_tx_isr(void)
 {
+	/* Xon/Xoff go out of band, ahead of the queue and regardless of the peer's Xoff */
+	if (tx_flow())
+		return;
 #ifdef TXBUFFER
-	/* Copy the character from the TX queue into the TX register */
-	TX2REG = tx.buffer[tx.tail];
-	/* Dequeue the character */
-	tx.tail++;
-
-	/* Disable tx interrupt if queue is empty */
-	if (tx.head == tx.tail)
+	if (tx.xon_enabled && !tx.xon_state) {
+		/* Held by the peer */
 		TX2IE = 0;
+		return;
+	}
+	if (tx.head != tx.tail) {
+		/* Copy the character from the TX queue into the TX register */
+		TX2REG = tx_buffer[tx.tail & TX_BUFFER_MASK];
+		/* Dequeue the character */
+		tx.tail++;
+		/* Keep the tx interrupt enabled if there's more to send */
+		if ((tx.head != tx.tail) || tx_data_len)
+			return;
+		TX2IE = 0;
+		return;
+	}
 #endif /* TXBUFFER */
+	/* Then the data handed over by uart2_send() */
+	if (tx_data_len) {
+		TX2REG = *tx_data++;
+		if (--tx_data_len)
+			return;
+		/* Done, the next can be handed over */
+		event_post(EVENT_UART2_TX);
+	}
+	/* Disable tx interrupt, nothing left to send */
+	TX2IE = 0;
 }
 
 
-/* Hook to stdout */
-void putch(char ch)
+/* Test if a character can be sent without waiting */
+unsigned char uart2_tx_ready(void)
+{
+#ifdef TXBUFFER
+	return FREE(tx.head, tx.tail, TX_BUFFER_SIZE) != 0;
+#else
+	return RC2STAbits.SPEN && TX2IF;
+#endif /* TXBUFFER */
+}
+
+
+/* Test if len characters (at most a queue full) can be sent without waiting */
+unsigned char uart2_tx_room(unsigned char len)
+{
+#ifdef TXBUFFER
+	if (len > TX_BUFFER_SIZE)
+		len = TX_BUFFER_SIZE;
+	return FREE(tx.head, tx.tail, TX_BUFFER_SIZE) >= len;
+#else
+	/* Without a queue, every character waits for the transmitter anyway */
+	(void)len;
+	return 1;
+#endif /* TXBUFFER */
+}
+
+
+/*
+ * Hands len bytes to the tx interrupt to send after anything queued, so the
+ * caller doesn't wait for them. They have to stay put until
+ * uart2_sending() returns 0, which EVENT_UART2_TX announces. Returns 0
+ * without taking them while the previous ones are still being sent.
+ */
+unsigned char uart2_send(const char *data, unsigned char len)
+{
+	if (tx_data_len)
+		return 0;
+	tx_data     = data;
+	tx_data_len = len;	/* Written last, the tx interrupt only looks at tx_data when this is set */
+	TX2IE      = 1;
+
+	return 1;
+}
+
+
+unsigned char uart2_sending(void)
+{
+	return tx_data_len != 0;
+}
+
+
+/*
+ * Queue a character for transmission. When the queue is full, only
+ * UART2_TX_BLOCK or uart2_tx_wait() waits for room, the other policies
+ * return right away and count the character dropped.
+ */
+void uart2_putch(char ch)
 {
 #ifdef TXBUFFER
 	unsigned char	queued = 0;
@@ -198,16 +342,24 @@ void putch(char ch)
 #endif /* RXBUFFER */
 		TX2IE = 0;	/* Disable tx interrupt for concurrency */
 
-		/* Check if there's room in the queue ((tx.head + 1) != tx.tail won't work due to bitfields being cast) */
-		if (FREE(tx.head, tx.tail, BUFFER_SIZE)) {
+		/* Make room by dropping the oldest character, tail is safe with the tx interrupt disabled */
+		if (!FREE(tx.head, tx.tail, TX_BUFFER_SIZE) && !tx_wait && tx_policy == UART2_TX_DROP_OLD) {
+			tx.tail++;
+			tx_lost++;
+		}
+		/* Check if there's room in the queue */
+		if (FREE(tx.head, tx.tail, TX_BUFFER_SIZE)) {
 			/* Copy the character into the TX queue */
-			tx.buffer[tx.head] = ch;
+			tx_buffer[tx.head & TX_BUFFER_MASK] = ch;
 			/* Queue the character */
 			tx.head++;
 			queued = 1;
+		} else if (!tx_wait && tx_policy == UART2_TX_DROP_NEW) {
+			tx_lost++;
+			queued = 1;
 		} else
 			CLRWDT();
-		if (!tx.xon_enabled || tx.xon_state)
+		if (FLOW_PENDING() || !tx.xon_enabled || tx.xon_state)
 			TX2IE = 1;	/* Re-enable tx interrupt */
 #ifdef RXBUFFER
 		RC2IE = 1;	/* Re-enable rx interrupt */
@@ -216,83 +368,178 @@ void putch(char ch)
 #else
 	if (!RC2STAbits.SPEN)
 		return;
-	while(!TX2IF) {	/* Wait for TX2REG to be empty */
-		if (RC2STAbits.OERR) {
-			TX2STAbits.TXEN = 0;
-			TX2STAbits.TXEN = 1;
-			RC2STAbits.CREN = 0;
-			RC2STAbits.CREN = 1;
-		}
-		if (RC2STAbits.FERR) {
-			volatile unsigned char dummy;
-
-			dummy = RC2REG;
-			TX2STAbits.TXEN = 0;
-			TX2STAbits.TXEN = 1;
-		}
-		CLRWDT();
+	for (;;) {
+		/* Wait for TX2REG to be empty, receive errors are up to the receive path */
+		while(!TX2IF)
+			CLRWDT();
+#ifdef RXBUFFER
+		RC2IE = 0;	/* Disable rx interrupt for concurrency */
+#endif /* RXBUFFER */
+		TX2IE = 0;	/* Keep the tx interrupt off TX2REG */
+		/* A pending Xon/Xoff goes first, then wait for room again */
+		if (!tx_flow())
+			break;
+#ifdef RXBUFFER
+		RC2IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
 	}
 	TX2REG = ch;
+	if (tx_data_len)
+		TX2IE = 1;	/* Carry on with data handed over by uart2_send() */
+#ifdef RXBUFFER
+	RC2IE = 1;	/* Re-enable rx interrupt */
+#endif /* RXBUFFER */
 	CLRWDT();
 #endif /* TXBUFFER */
 }
 
 
+/* Hook to stdout */
+void putch(char ch)
+{
+	if (console)
+		uart2_putch(ch);
+}
+
+
+/* Enable or disable console output, for when the transmitter serves another purpose */
+void uart2_console(unsigned char enable)
+{
+	console = enable;
+}
+
+
+void uart2_tx_policy(enum uart2_tx_policy_t policy)
+{
+#ifdef TXBUFFER
+	tx_policy = policy;
+#endif /* TXBUFFER */
+}
+
+
+/* Wait for room regardless of the policy, for output that was asked for */
+void uart2_tx_wait(unsigned char wait)
+{
+#ifdef TXBUFFER
+	tx_wait = wait;
+#endif /* TXBUFFER */
+}
+
+
+enum uart2_tx_policy_t uart2_tx_get_policy(void)
+{
+#ifdef TXBUFFER
+	return tx_policy;
+#else
+	return UART2_TX_BLOCK;
+#endif /* TXBUFFER */
+}
+
+
+/* Free-running count of characters dropped by the policy */
+unsigned long uart2_tx_lost(void)
+{
+#ifdef TXBUFFER
+	return tx_lost;
+#else
+	return 0;
+#endif /* TXBUFFER */
+}
+
+
 /* Hook to stdin */
 char getche(void)
 {
 #ifdef RXBUFFER
 	char  result = EOF;
 
-	RC2IE = 0;	/* Disable rx interrupt for concurrency */
-#ifdef TXBUFFER
-	TX2IE = 0;	/* Disable tx interrupt for concurrency */
-#endif /* TXBUFFER */
-
 	/* Check if there's anything to read */
 	if (rx.head != rx.tail) {
 		/* Copy the character from the RX queue */
-		result = rx.buffer[rx.tail];
+		result = rx_buffer[rx.tail & BUFFER_MASK];
 		/* Dequeue the character */
 		rx.tail++;
 		/* Check if an Xon is in required */
-		if (rx.xon_enabled &&
-		    !rx.xon_state &&
-		    (rx.head == rx.tail)) {
-			while(!TX2IF);
-			TX2REG = XON;
-			rx.xon_state = 1;
-		}
+		rx_dequeued();
 	}
 
-	RC2IE = 1;	/* Re-enable rx interrupt */
-#ifdef TXBUFFER
-	if ((tx.head != tx.tail) && (!tx.xon_enabled || tx.xon_state))
-		TX2IE = 1;	/* Re-enable tx interrupt */
-#endif /* TXBUFFER */
-
 	return result;
 
 #else /* !RXBUFFER */
 	if (!RCIF)
 		return EOF;
 
+	/* Reset only the receiver, leaving the transmitter alone */
 	if (RC2STAbits.OERR) {
-		TX2STAbits.TXEN = 0;
-		TX2STAbits.TXEN = 1;
 		RC2STAbits.CREN = 0;
 		RC2STAbits.CREN = 1;
 		return 0;
 	}
 	if (RC2STAbits.FERR) {
-		volatile unsigned char dummy;
-
-		dummy = RC2REG;
-		TX2STAbits.TXEN = 0;
-		TX2STAbits.TXEN = 1;
+		(void)RC2REG;
 		return 0;
 	}
 
 	return RC2REG;
 #endif /* RXBUFFER */
 }
+
+
+/* Get the contiguous span of received characters, without dequeuing them */
+unsigned char uart2_rx_span(const char **data)
+{
+#ifdef RXBUFFER
+	unsigned char  used = USED(rx.head, rx.tail);  /* Snapshot, the producer can only add to it */
+	unsigned char  offset = rx.tail & BUFFER_MASK;
+
+	*data = (const char *)&rx_buffer[offset];
+
+	/* The span ends at the end of the buffer, the rest follows on the next call */
+	if (used > BUFFER_SIZE - offset)
+		used = BUFFER_SIZE - offset;
+
+	return used;
+#else /* !RXBUFFER */
+	*data = NULL;
+	return 0;
+#endif /* RXBUFFER */
+}
+
+
+/* Dequeue characters previously obtained through uart2_rx_span() */
+void uart2_rx_commit(unsigned char len)
+{
+#ifdef RXBUFFER
+	rx.tail += len;
+	rx_dequeued();
+#endif /* RXBUFFER */
+}
+
+
+/* Copy and dequeue up to len received characters, returns the number of characters copied */
+unsigned char uart2_read(char *buf, unsigned char len)
+{
+#ifdef RXBUFFER
+	unsigned char  count = 0;
+	unsigned char  head = rx.head;  /* Snapshot, the producer can only add to it */
+	unsigned char  tail = rx.tail;
+
+	while ((count < len) && (head != tail))
+		buf[count++] = rx_buffer[tail++ & BUFFER_MASK];
+	if (count) {
+		/* Dequeue everything copied at once */
+		rx.tail = tail;
+		rx_dequeued();
+	}
+
+	return count;
+#else /* !RXBUFFER */
+	char  ch;
+
+	if (!len || (ch = getche()) == (char)EOF)
+		return 0;
+	buf[0] = ch;
+
+	return 1;
+#endif /* RXBUFFER */
+}
@@ -8,11 +8,38 @@
 #define UART2_H
 
 
+/* What to do with console output when the transmit queue is full */
+enum uart2_tx_policy_t {
+	UART2_TX_BLOCK = 0,             /* Wait for room, stalling the caller */
+	UART2_TX_DROP_NEW,              /* Drop the new character */
+	UART2_TX_DROP_OLD,              /* Drop the oldest queued character */
+	UART2_TX_POLICIES
+};
+
+
+#define UART2_TX_LEN	64	/* Size of the transmit queue, large enough for a few lines of console output. Has to be a power of 2, no larger than 128 */
+
+
 void           uart2_init  (unsigned long  bitrate,
                             unsigned char  flow);
 void           uart2_term  (void);
 void           uart2_rx_isr(void);
 void           uart2_tx_isr(void);
+unsigned char  uart2_tx_ready(void);
+unsigned char  uart2_tx_room(unsigned char  len);
+unsigned char  uart2_send  (const char     *data,
+                            unsigned char  len);
+unsigned char  uart2_sending(void);
+void           uart2_putch (char           ch);
+void           uart2_console(unsigned char enable);
+void           uart2_tx_policy(enum uart2_tx_policy_t policy);
+enum uart2_tx_policy_t uart2_tx_get_policy(void);
+void           uart2_tx_wait(unsigned char  wait);
+unsigned long  uart2_tx_lost(void);
+unsigned char  uart2_rx_span(const char     **data);
+void           uart2_rx_commit(unsigned char  len);
+unsigned char  uart2_read  (char           *buf,
+                            unsigned char  len);
 
 
 #endif /* UART2_H */